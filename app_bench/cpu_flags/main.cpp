@@ -0,0 +1,82 @@
+#include "emu/address/absolute_address.h"
+#include "emu/bus/memory_only_bus.h"
+#include "emu/cpu/vcpu.h"
+#include "emu/file/bin_file.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <print>
+#include <stdexcept>
+#include <vector>
+
+namespace emu::bench {
+
+/** Number of runs of the test per measurement. */
+constexpr std::size_t num_runs = 15;
+
+#ifdef EMU_LAZY_FLAGS
+constexpr char const* flags_mode = "lazy";
+#else
+constexpr char const* flags_mode = "eager";
+#endif
+
+/** Runs the 6502 functional test (see app_test/test1) to its success trap and returns the CPU throughput in Mcps. */
+double run_functional_test(std::vector<std::uint8_t> const& program) {
+    constexpr auto entry_point_addr  = absolute_address{0x0400};
+    constexpr auto success_trap_addr = absolute_address{0x336D};
+
+    using vbus = bus::memory_only_bus;
+    vbus::memory_array memory;
+
+    vbus bus(memory);
+    cpu::vcpu cpu(bus);
+
+    bus.set_ram_bytes(program);
+    auto const start_time = std::chrono::steady_clock::now();
+
+    try {
+        cpu.run_at(entry_point_addr);
+        throw std::runtime_error("Reached unexpected code path");
+    }
+    catch (cpu::infinite_loop const& ex) {
+        if (ex.address() != success_trap_addr)
+            throw;
+    }
+
+    std::chrono::duration<double, std::micro> const duration = std::chrono::steady_clock::now() - start_time;
+    return cpu.cycle_counter() / duration.count();
+}
+
+/**
+ * Measures the CPU with the status register of this build (see EMU_LAZY_FLAGS). Run both app_bench_eager_flags and
+ * app_bench_lazy_flags to compare the flag evaluations.
+ */
+void run() {
+    std::vector<std::uint8_t> const program = read_bin_file("6502_functional_test.bin");
+
+    std::vector<double> mcps;
+    for (std::size_t run = 0; run < num_runs; ++run)
+        mcps.push_back(run_functional_test(program));
+
+    std::ranges::sort(mcps);
+
+    std::println("6502 functional test, {} flags, {} runs", flags_mode, num_runs);
+    std::println("median (Mcps)   best (Mcps)");
+    std::println("{:13.1f}   {:11.1f}", mcps[num_runs / 2], mcps.back());
+}
+
+} // namespace emu::bench
+
+int main() {
+    try {
+        emu::bench::run();
+        return EXIT_SUCCESS;
+    }
+    catch (std::exception const& ex) {
+        std::println("Exception: {}", ex.what());
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,151 @@
+#include "emu/ppu/background_shift_register.h"
+#include "emu/ppu/types.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <print>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace emu::bench {
+
+using namespace emu::ppu;
+
+/** Number of dots per scanline. */
+constexpr std::uint16_t num_dots_per_scanline = 341;
+
+/** Number of scanlines rendered per measurement. */
+constexpr std::size_t num_scanlines = 1'000'000;
+
+/** Returns true if the background pipeline shifts at a dot (same as cycle_counter::is_bg_fetch()). */
+constexpr bool is_bg_fetch(std::uint16_t dot) noexcept {
+    return (dot >= 1 && dot <= 256) || (dot >= 321 && dot <= 336);
+}
+
+/** Tile rows with palettes, as fetched during a scanline. */
+struct tile_source {
+    std::vector<decoded_tile_row> rows;
+    std::vector<color_index> palettes;
+};
+
+tile_source make_tile_source(std::size_t count) {
+    std::mt19937_64 rng(42);
+
+    tile_source src;
+    for (std::size_t i = 0; i < count; ++i) {
+        src.rows.push_back(decoded_tile_row{rng() & 0x0303030303030303});
+        src.palettes.push_back(color_index{static_cast<std::uint8_t>((rng() & 3) << 2)});
+    }
+
+    return src;
+}
+
+/** Background pipeline before: 16 color indices moved by one element on every fetch dot. */
+class copy_pipeline {
+public:
+    void shift() {
+        std::copy(my_tile_data.begin() + 1, my_tile_data.end(), my_tile_data.begin());
+    }
+
+    void load(decoded_tile_row row, color_index palette) {
+        decode(row, palette, std::span<color_index, 8>(my_tile_data.begin() + 8, 8));
+    }
+
+    color_index pixel(std::uint8_t fine_x) const {
+        return my_tile_data[fine_x];
+    }
+
+private:
+    std::array<color_index, 16> my_tile_data = {};
+};
+
+/** Background pipeline after: a pair of 64-bit shift registers. */
+class shift_pipeline {
+public:
+    void shift() {
+        my_shifter.shift();
+    }
+
+    void load(decoded_tile_row row, color_index palette) {
+        my_shifter.load(apply_palette(row, palette));
+    }
+
+    color_index pixel(std::uint8_t fine_x) const {
+        return my_shifter.pixel(fine_x);
+    }
+
+private:
+    background_shift_register my_shifter;
+};
+
+/**
+ * Runs the background part of vppu::step() for a number of scanlines and returns the time per scanline in
+ * nanoseconds. The checksum keeps the pixels from being optimized away.
+ */
+template<class Pipeline>
+double measure(tile_source const& src, std::uint8_t fine_x, std::uint64_t& checksum) {
+    Pipeline pipeline;
+    std::size_t tile = 0;
+
+    auto const start = std::chrono::steady_clock::now();
+
+    for (std::size_t line = 0; line < num_scanlines; ++line) {
+        for (std::uint16_t dot = 0; dot < num_dots_per_scanline; ++dot) {
+            if (dot >= 1 && dot <= 256)
+                checksum += std::to_underlying(pipeline.pixel(fine_x));
+
+            if (!is_bg_fetch(dot))
+                continue;
+
+            pipeline.shift();
+            if (dot % 8 == 0) {
+                pipeline.load(src.rows[tile], src.palettes[tile]);
+                tile = (tile + 1) % src.rows.size();
+            }
+        }
+    }
+
+    std::chrono::duration<double, std::nano> const elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / num_scanlines;
+}
+
+void run() {
+    tile_source const src = make_tile_source(4096);
+
+    std::println("Background pipeline, {} scanlines per run", num_scanlines);
+    std::println("fine X   std::copy (ns/line)   shift register (ns/line)");
+
+    std::uint64_t copy_checksum = 0;
+    std::uint64_t shift_checksum = 0;
+
+    for (std::uint8_t fine_x = 0; fine_x < 8; ++fine_x) {
+        double const copy_ns = measure<copy_pipeline>(src, fine_x, copy_checksum);
+        double const shift_ns = measure<shift_pipeline>(src, fine_x, shift_checksum);
+
+        std::println("{:6}   {:19.1f}   {:24.1f}", fine_x, copy_ns, shift_ns);
+    }
+
+    if (copy_checksum != shift_checksum)
+        throw std::runtime_error("Pipelines produced different pixels");
+}
+
+} // namespace emu::bench
+
+int main() {
+    try {
+        emu::bench::run();
+        return EXIT_SUCCESS;
+    }
+    catch (std::exception const& ex) {
+        std::println("Exception: {}", ex.what());
+        return EXIT_FAILURE;
+    }
+}
@@ -2,35 +2,44 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstddef>
 #include <print>
 #include <span>
 #include <thread>
 
 namespace emu::app {
 
-/** Creates a mono audio stream with the given sample rate. */
-audio_stream::audio_stream(unsigned int sample_rate) : my_fifo(buffer_size) {
+/** Creates a mono audio stream with the given sample rate that keeps about target_latency of samples queued. */
+audio_stream::audio_stream(unsigned int sample_rate, std::chrono::milliseconds target_latency) :
+    // The device pulls whole chunks, so the target includes at least one chunk beyond the one being played
+    my_target_fill(std::max<std::size_t>(sample_rate * target_latency.count() / 1000, 2 * samples_size)),
+    my_average_fill(0),
+    // Leave room for the fill level to swing above the target while the rate adjusts
+    my_fifo(2 * my_target_fill + samples_size) {
     initialize(1, sample_rate);
 }
 
-/** Pushes a block into the internal FIFO. Blocks until enough space becomes available. */
+/** Pushes a block into the internal FIFO without waiting; the block is dropped if the FIFO is full. */
 void audio_stream::push(std::span<sf::Int16 const> values) {
-    while (true) {
-        if (my_fifo.push(values))
-            return;
+    if (!my_fifo.push(values))
+        std::println("Audio buffer overflow, {} elements dropped", values.size());
+}
 
-        auto const drain_seq = my_drain_seq.load(std::memory_order_acquire);
+/** Returns the factor by which the producer should scale its nominal sample rate. */
+double audio_stream::rate_ratio() noexcept {
+    // The fill level drops by a whole chunk whenever the device pulls one, so it is smoothed before it steers the rate
+    auto const fill = static_cast<double>(my_fifo.size());
+    my_average_fill += fill_smoothing * (fill - my_average_fill);
 
-        if (my_fifo.push(values))
-            return;
+    auto const target = static_cast<double>(my_target_fill);
+    double const error = std::clamp((target - my_average_fill) / target, -1.0, 1.0);
 
-        my_drain_seq.wait(drain_seq, std::memory_order_relaxed);
-    }
+    return 1 + max_rate_deviation * error;
 }
 
 /** Waits until the FIFO has been prefilled enough for playback to start. */
 void audio_stream::wait_until_prefilled() {
-    while (my_fifo.size() < samples_size)
+    while (my_fifo.size() < my_target_fill)
         std::this_thread::sleep_for(std::chrono::milliseconds(1));
 }
 
@@ -45,11 +54,6 @@ bool audio_stream::onGetData(sf::SoundStream::Chunk& data) {
         std::fill(my_samples.begin() + chunk_size, my_samples.end(), fill_value);
     }
 
-    if (chunk_size > 0) {
-        my_drain_seq.fetch_add(1, std::memory_order_release);
-        my_drain_seq.notify_one();
-    }
-
     data.samples = my_samples.data();
     data.sampleCount = my_samples.size();
     return true;
@@ -5,7 +5,8 @@
 
 #include <SFML/Audio.hpp>
 
-#include <atomic>
+#include <algorithm>
+#include <chrono>
 #include <concepts>
 #include <cstddef>
 #include <limits>
@@ -14,7 +15,9 @@
 namespace emu::app {
 
 /**
- * Streamed audio source that plays audio samples generated by the emulator.
+ * Streamed audio source that plays audio samples generated by the emulator. The producer never waits for the FIFO to
+ * drain; instead it adjusts its sample rate by rate_ratio(), which keeps the FIFO at the fill level of the target
+ * latency despite drift between the emulation and the audio device clocks.
  */
 class audio_stream : public sf::SoundStream {
 public:
@@ -22,13 +25,19 @@ public:
     static constexpr std::size_t block_size = 128;
 
 public:
-    /** Creates a mono audio stream with the given sample rate. */
-    explicit audio_stream(unsigned int sample_rate);
+    /** Creates a mono audio stream with the given sample rate that keeps about target_latency of samples queued. */
+    audio_stream(unsigned int sample_rate, std::chrono::milliseconds target_latency);
 
 public:
-    /** Pushes a block into the internal FIFO. Blocks until enough space becomes available. */
+    /** Pushes a block into the internal FIFO without waiting; the block is dropped if the FIFO is full. */
     void push(std::span<value_type const> values);
 
+    /**
+     * Returns the factor by which the producer should scale its nominal sample rate. It is above 1 while the FIFO
+     * holds less than the target latency and below 1 while it holds more, by at most max_rate_deviation.
+     */
+    double rate_ratio() noexcept;
+
     /** Waits until the FIFO has been prefilled enough for playback to start. */
     void wait_until_prefilled();
 
@@ -41,21 +50,27 @@ private:
 
 private:
     static constexpr std::size_t samples_size = 4 * block_size;
-    static constexpr std::size_t buffer_size  = 4 * samples_size;
+
+    /** Maximum relative change of the sample rate; small enough to keep the pitch shift inaudible. */
+    static constexpr double max_rate_deviation = 0.005;
+
+    /** Weight of the current FIFO fill level in its moving average. */
+    static constexpr double fill_smoothing = 1.0 / 64;
+
+    std::size_t my_target_fill;   // FIFO fill level of the target latency
+    double      my_average_fill;  // Moving average of the FIFO fill level, as seen by the producer
 
     emu::spsc_ring_buffer<value_type>       my_fifo;
     dynamic_array<value_type, samples_size> my_samples;
-
-    std::atomic<unsigned long long> my_drain_seq = 0;
 };
 
 /////////////////////////////////////////////////////////////////////////
 
-/** Linearly maps a value from [0, 1] to the integral range [-M, M], where M = max(T). */
+/** Linearly maps a value from [0, 1] to the integral range [-M, M], where M = max(T). Values outside are clamped. */
 template<std::signed_integral T>
 T to_pcm_sample(double value) noexcept {
     constexpr T max = std::numeric_limits<T>::max();
-    return static_cast<T>(max * (2 * value - 1));
+    return static_cast<T>(max * (2 * std::clamp(value, 0.0, 1.0) - 1));
 }
 
 } // namespace emu::app
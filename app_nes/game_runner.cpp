@@ -5,18 +5,22 @@
 #include "keyboard_controller.h"
 #include "main_window.h"
 
+#include "emu/apu/blip_buffer.h"
+#include "emu/apu/output_filter.h"
 #include "emu/apu/vapu.h"
 #include "emu/bus/nes_system_bus.h"
 #include "emu/bus/random_access_memory.h"
 #include "emu/constants.h"
+#include "emu/cpu/idle_loop_detector.h"
 #include "emu/file/nes_file.h"
 #include "emu/mapper.h"
 #include "emu/ppu/frame_buffer.h"
 #include "emu/ppu/vppu.h"
-#include "emu/utility/cyclic_counter.h"
 
 #include <SFML/Graphics.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <exception>
 #include <filesystem>
@@ -35,6 +39,7 @@ namespace emu::app {
 
 constexpr std::uint32_t nes_cpu_clock = 1'789'773;      // Cycles per second (PAL)
 constexpr std::uint32_t audio_sample_rate = 44'100;     // Audio frames per second
+constexpr std::chrono::milliseconds audio_latency{50};  // Audio queued ahead of playback
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -63,50 +68,108 @@ void game_runner::run_with_mapper(std::type_identity<Mapper>) {
 
     keyboard_controller controller;
     apu::vapu apu(controller);
+    apu.set_dma_reader([&mapper](abstract_address addr) { return mapper.load_prg(addr); });
 
     random_access_memory ram;
     system_bus bus(ram, mapper, ppu, apu);
 
-    cpu::vcpu cpu(bus);
-
-    ppu.set_cpu(cpu);
-
 //#define disasm
 
 #ifdef disasm
-    cpu.set_exec_callback([&](cpu_type const& cpu, cpu_type::disasm_info const& info) {
+    cpu::vcpu<system_bus, cpu::callback_trace> cpu(bus);
+
+    cpu.trace().set_callback([&](cpu::vcpu_state const& cpu, cpu::disasm_info const& info) {
         std::string const regs = std::format("A:{:02X} X:{:02X} Y:{:02X} P:{:02X} SP:{:02X}", cpu.a(), cpu.x(), cpu.y(), cpu.flags().to_uint(), cpu.sp());
 
         std::string const status = std::format("{:04X}  {:9s}{:31s}  {:s} CYC:{}", info.pc.value(), info.bytes, info.instr_name + " " + info.operand, regs, cpu.cycle_counter());
         std::cout << status << std::endl;
     });
+#else
+    cpu::vcpu cpu(bus);
 #endif
 
+    ppu.set_cpu(cpu);
+
     main_window wnd;
 
-    audio_stream stream(audio_sample_rate);
+    audio_stream stream(audio_sample_rate, audio_latency);
     bulk_queue<sf::Event> keyboard_events;
 
+    // The APU adds its output to the buffer as band-limited amplitude changes, converted to samples block by block
+    apu::blip_buffer audio_buffer(nes_cpu_clock, audio_sample_rate, 4 * audio_stream::block_size);
+    apu.set_output_buffer(&audio_buffer);
+    apu::output_filter audio_filter(audio_sample_rate);
+
     std::jthread system_thread([&](std::stop_token stop_token) {
+        std::array<float, audio_stream::block_size> audio_output_block;
         std::array<sf::Int16, audio_stream::block_size> audio_samples_block;
-        cyclic_counter<std::uint32_t, nes_cpu_clock> audio_samples_counter;
+        cpu::idle_loop_detector<decltype(cpu)> idle_loops;
+
+        using clock = std::chrono::steady_clock;
+        clock::time_point block_deadline = clock::now();
 
         while (!stop_token.stop_requested()) {
             keyboard_events.consume_all([&](auto& event) {
                 controller.process_keyboard_event(event);
             });
 
-            auto it = audio_samples_block.begin();
-            while (it < audio_samples_block.end()) {
-                auto const cpu_cycles = cpu.step();
-                ppu.step(cpu_cycles);
-                apu.step(cpu_cycles);
-
-                if (audio_samples_counter.increment(cpu_cycles * audio_sample_rate))
-                    *it++ = to_pcm_sample<audio_stream::value_type>(apu.output());
+            // Run the system until the buffer can produce a whole block
+            std::uint64_t const block_cycles = audio_buffer.clocks_needed(audio_stream::block_size);
+
+            // The PPU catches up on register accesses by itself (see vppu::catch_up()); otherwise only at frame events
+            auto frame_event_cycle = ppu.next_frame_event_cycle();
+
+            while (apu.block_cycles() < block_cycles) {
+                absolute_address const old_pc = cpu.pc();
+                apu.step(cpu.step());
+
+                // DMC sample fetches stall the CPU; charge the stalls once a fetch is due. This comes before the
+                // frame event check, so the cycle counter never passes a frame event unnoticed
+                if (apu.cycles_until_dma() == 0) {
+                    auto const stall_cycles = apu.take_stall_cycles();
+                    cpu.advance_cycle_counter(stall_cycles);
+                    apu.step(stall_cycles);
+                }
+
+                if (cpu.cycle_counter() >= frame_event_cycle) {
+                    ppu.catch_up();
+                    frame_event_cycle = ppu.next_frame_event_cycle();
+                }
+
+                // An idle loop repeats identically until the next frame event or DMC fetch; skip iterations up to it
+                if (auto const loop_cycles = idle_loops.observe(cpu, old_pc)) {
+                    auto const cycles_until_event = std::min(frame_event_cycle - cpu.cycle_counter(),
+                                                             apu.cycles_until_dma());
+                    auto const cycles_until_block_end = block_cycles - std::min(block_cycles, apu.block_cycles());
+
+                    auto const num_iterations = std::min(cycles_until_event / loop_cycles,
+                                                         (cycles_until_block_end + loop_cycles - 1) / loop_cycles);
+                    cpu.advance_cycle_counter(num_iterations * loop_cycles);
+                    apu.step(num_iterations * loop_cycles);
+                }
             }
 
-            stream.push(audio_samples_block);  // blocks if stream buffer is full
+            std::uint64_t const emulated_cycles = apu.block_cycles();
+
+            apu.end_block();
+            audio_buffer.read_samples(audio_output_block);
+            audio_filter.process(audio_output_block);
+
+            // The filtered output is centered at 0 instead of 0.5
+            std::ranges::transform(audio_output_block, audio_samples_block.begin(), [](float value) {
+                return to_pcm_sample<audio_stream::value_type>(value + 0.5);
+            });
+
+            stream.push(audio_samples_block);
+
+            // Resample the next block at the rate that keeps the stream at its target latency
+            audio_buffer.set_sample_rate(audio_sample_rate * stream.rate_ratio());
+
+            // Run the emulation in real time; after a stall longer than the latency, resume from now instead
+            block_deadline += std::chrono::duration_cast<clock::duration>(
+                std::chrono::duration<double>(static_cast<double>(emulated_cycles) / nes_cpu_clock));
+            block_deadline = std::max(block_deadline, clock::now() - audio_latency);
+            std::this_thread::sleep_until(block_deadline);
         }
     });
 
@@ -127,7 +190,12 @@ void game_runner::run_with_mapper(std::type_identity<Mapper>) {
                     keyboard_events.push(*event);
             }
 
-            wnd.update_image(image.acquire().span());
+            // Upload only the rows that changed since the last frame, if any
+            ppu::frame_buffer::image_span const frame = image.acquire();
+            ppu::for_each_row_range(image.changed_rows(), [&](std::uint16_t first_row, std::uint16_t num_rows) {
+                wnd.update_image(frame, first_row, num_rows);
+            });
+
             wnd.display();
         }
     };
@@ -139,6 +207,8 @@ void game_runner::run_with_mapper(std::type_identity<Mapper>) {
 
     stream.stop();
     wnd.close();
+
+    std::cout << std::format("Frames dropped: {}, repeated: {}\n", image.dropped_frames(), image.repeated_frames());
 }
 
 } // namespace emu::app
@@ -15,6 +15,11 @@ void main_window::update_image(ppu::frame_buffer::image_span image) {
     my_texture.update(reinterpret_cast<sf::Uint8 const*>(image.data()));
 }
 
+void main_window::update_image(ppu::frame_buffer::image_span image, std::uint16_t first_row, std::uint16_t num_rows) {
+    auto const* const pixels = image.subspan(std::size_t{first_row} * ppu::frame_buffer::width).data();
+    my_texture.update(reinterpret_cast<sf::Uint8 const*>(pixels), ppu::frame_buffer::width, num_rows, 0, first_row);
+}
+
 void main_window::display() {
     my_window.draw(my_sprite);
     my_window.display();
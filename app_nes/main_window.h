@@ -4,6 +4,8 @@
 
 #include <SFML/Graphics.hpp>
 
+#include <cstdint>
+
 namespace emu::app {
 
 class main_window {
@@ -12,6 +14,9 @@ public:
 
     void update_image(ppu::frame_buffer::image_span);
 
+    /** Uploads only a range of rows of the image. */
+    void update_image(ppu::frame_buffer::image_span, std::uint16_t first_row, std::uint16_t num_rows);
+
     void display();
 
     void close();
@@ -0,0 +1,155 @@
+#include "emu/apu/vapu.h"
+#include "emu/bus/nes_system_bus.h"
+#include "emu/bus/random_access_memory.h"
+#include "emu/controller/vcontroller.h"
+#include "emu/cpu/opcode_pair_profile.h"
+#include "emu/cpu/vcpu.h"
+#include "emu/file/nes_file.h"
+#include "emu/mapper.h"
+#include "emu/ppu/frame_buffer.h"
+#include "emu/ppu/vppu.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <print>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace emu::profile {
+
+/** Number of CPU cycles per frame. */
+constexpr std::uint64_t num_cycles_per_frame = 29'781;
+
+/** Number of most frequent opcode pairs to report. */
+constexpr std::size_t num_top_pairs = 32;
+
+/** Controller with no buttons pressed. */
+class idle_controller : public vcontroller {};
+
+/**
+ * Runs a NES file for a number of frames without video and audio output and adds the executed opcode pairs
+ * to a profile.
+ */
+template<class Mapper>
+void profile_nes_file(nes_file& nf, std::uint64_t num_frames, cpu::opcode_pair_profile& profile) {
+    Mapper mapper(nf.prg_rom, nf.chr_rom);
+
+    using system_bus = bus::nes_system_bus<Mapper, ppu::vppu<Mapper>, apu::vapu>;
+
+    ppu::frame_buffer image;
+    ppu::vppu ppu(mapper, nf.mirroring, image);
+    ppu.set_render_mode(ppu::render_mode::none);
+
+    idle_controller controller;
+    apu::vapu apu(controller);
+    apu.set_dma_reader([&mapper](abstract_address addr) { return mapper.load_prg(addr); });
+
+    random_access_memory ram;
+    system_bus bus(ram, mapper, ppu, apu);
+
+    cpu::vcpu<system_bus, cpu::opcode_pair_profile> cpu(bus);
+    ppu.set_cpu(cpu);
+
+    std::uint64_t const end_cycle = cpu.cycle_counter() + num_frames * num_cycles_per_frame;
+    auto frame_event_cycle = ppu.next_frame_event_cycle();
+
+    while (cpu.cycle_counter() < end_cycle) {
+        apu.step(cpu.step());
+
+        if (apu.cycles_until_dma() == 0) {
+            auto const stall_cycles = apu.take_stall_cycles();
+            cpu.advance_cycle_counter(stall_cycles);
+            apu.step(stall_cycles);
+        }
+
+        if (cpu.cycle_counter() >= frame_event_cycle) {
+            ppu.catch_up();
+            frame_event_cycle = ppu.next_frame_event_cycle();
+        }
+    }
+
+    profile.merge(cpu.trace());
+}
+
+/** Type of the CPU used to disassemble the profiled opcodes; the opcode table does not depend on the bus. */
+using disasm_cpu = cpu::vcpu<bus::nes_system_bus<mapper::mapper_000_nrom, ppu::vppu<mapper::mapper_000_nrom>, apu::vapu>>;
+
+/**
+ * Profiles NES files and prints the most frequent opcode pairs. If a header path is given, also writes the pairs
+ * that can be fused to it as a new superinstructions.h.
+ */
+void run(std::uint64_t num_frames, std::span<char* const> nes_file_paths, std::filesystem::path const& header_path) {
+    cpu::opcode_pair_profile corpus_profile;
+    std::string corpus;
+
+    for (std::filesystem::path const nes_file_path : nes_file_paths) {
+        nes_file nf = read_nes_file(nes_file_path);
+
+        auto const profile_fn = [&](auto mapper_tag) {
+            using mapper_type = typename decltype(mapper_tag)::type;
+            profile_nes_file<mapper_type>(nf, num_frames, corpus_profile);
+        };
+
+        if (!mapper::with_mapper_type(nf.mapper, profile_fn))
+            std::println("Skipping {}: unsupported mapper", nes_file_path.string());
+        else {
+            std::println("Profiled {}", nes_file_path.string());
+            corpus += (corpus.empty() ? "" : ", ") + nes_file_path.filename().string();
+        }
+    }
+
+    auto const pairs = corpus_profile.top(num_top_pairs);
+
+    std::println("\nMost frequent opcode pairs:");
+    for (cpu::opcode_pair_count const& pair : pairs)
+        std::println("    {:02X} {:02X}  {}", pair.first, pair.second, pair.count);
+
+    std::println("\nSuperinstruction table (see emu/cpu/superinstructions.h):");
+    std::print("{}", cpu::to_superinstruction_table<disasm_cpu>(pairs));
+
+    if (!header_path.empty()) {
+        std::string const corpus_info = std::format("{} ({} frames each)", corpus, num_frames);
+
+        std::ofstream header(header_path);
+        header << cpu::to_superinstructions_header<disasm_cpu>(pairs, corpus_info);
+
+        if (!header)
+            throw std::runtime_error("Cannot write " + header_path.string());
+
+        std::println("\nWritten {}", header_path.string());
+    }
+}
+
+} // namespace emu::profile
+
+int main(int argc, char* argv[]) {
+    std::span<char* const> args(argv + 1, argc - 1);
+
+    // Optional path of the superinstructions.h to generate
+    std::filesystem::path header_path;
+    if (args.size() >= 2 && std::string_view(args[0]) == "-o") {
+        header_path = args[1];
+        args = args.subspan(2);
+    }
+
+    if (args.size() < 2) {
+        std::println("Usage: app_profile [-o <superinstructions.h>] <number-of-frames> <NES-file>...");
+        return EXIT_SUCCESS;
+    }
+
+    try {
+        emu::profile::run(std::stoull(args[0]), args.subspan(1), header_path);
+        return EXIT_SUCCESS;
+    }
+    catch (std::exception const& ex) {
+        std::println("Exception: {}", ex.what());
+        return EXIT_FAILURE;
+    }
+}
@@ -1,5 +1,7 @@
 #include "test1/test1.h"
 #include "test2/test2.h"
+#include "test3/test3.h"
+#include "test4/test4.h"
 
 #include <cstdlib>
 #include <exception>
@@ -7,14 +9,22 @@
 
 int main() {
     try {
-        std::println("[1/2] Running 6502 functional test...");
+        std::println("[1/4] Running 6502 functional test...");
         emu::test::run_6502_functional_test();
         std::println("PASSED");
 
-        std::println("[2/2] Running NES test...");
+        std::println("[2/4] Running NES test...");
         emu::test::run_nes_cpu_test();
         std::println("PASSED");
 
+        std::println("[3/4] Running APU test...");
+        emu::test::run_apu_test();
+        std::println("PASSED");
+
+        std::println("[4/4] Running PPU test...");
+        emu::test::run_ppu_test();
+        std::println("PASSED");
+
         return EXIT_SUCCESS;
     }
     catch (std::exception const& ex) {
@@ -39,8 +39,14 @@ void run_6502_functional_test() {
             throw;
     }
 
+#ifdef EMU_LAZY_FLAGS
+    constexpr char const* flags_mode = "lazy";
+#else
+    constexpr char const* flags_mode = "eager";
+#endif
+
     const std::chrono::duration<double, std::micro> duration = std::chrono::steady_clock::now() - start_time;
-    std::println("{:.2f} Mcps", cpu.cycle_counter() / duration.count());
+    std::println("{:.2f} Mcps ({} flags)", cpu.cycle_counter() / duration.count(), flags_mode);
 }
 
 } // namespace emu::test
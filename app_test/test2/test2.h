@@ -9,6 +9,7 @@
 #include "emu/file/nes_file.h"
 #include "emu/mapper/mapper_000_nrom.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
 #include <exception>
@@ -20,6 +21,8 @@
 #include <ranges>
 #include <set>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace emu::test {
@@ -63,9 +66,28 @@ bool compare_logs(std::vector<std::string> const& log1, std::vector<std::string>
     return true;
 }
 
-struct terminate_test {};
+/** Removes the memory values that the reference log shows after the operand of an instruction (e.g., "= 00"). */
+std::string strip_memory_values(std::string line) {
+    constexpr std::size_t asm_pos = 16;
+    constexpr std::size_t asm_size = 31;
 
-void run_nes_cpu_test() {
+    std::string_view const assembly = std::string_view(line).substr(asm_pos, asm_size);
+    std::size_t const end = std::min(assembly.find(" @ "), assembly.find(" = "));
+
+    if (end != std::string_view::npos)
+        std::fill(line.begin() + asm_pos + end, line.begin() + asm_pos + asm_size, ' ');
+
+    return line;
+}
+
+using nestest_bus = emu::bus::nes_system_bus<emu::mapper::mapper_000_nrom, vppu_stub, vapu_stub>;
+
+template<class TracePolicy>
+using nestest_cpu = emu::cpu::vcpu<nestest_bus, TracePolicy>;
+
+/** Runs nestest in automation mode up to the end of the reference log and returns the trace of the CPU. */
+template<class TracePolicy>
+TracePolicy run_nestest(TracePolicy trace) {
     emu::nes_file nf = emu::read_nes_file("nestest.nes");
     emu::random_access_memory ram;
 
@@ -75,33 +97,39 @@ void run_nes_cpu_test() {
         std::copy(nf.prg_rom.begin(), last, last);
     }
 
-    using system_bus = emu::bus::nes_system_bus<emu::mapper::mapper_000_nrom, vppu_stub, vapu_stub>;
-    using vcpu = emu::cpu::vcpu<system_bus>;
+    using vcpu = nestest_cpu<TracePolicy>;
 
     emu::mapper::mapper_000_nrom mapper(nf.prg_rom, nf.chr_rom);
 
     vppu_stub ppu_stub;
     vapu_stub apu_stub;
 
-    vcpu::bus_type bus(ram, mapper, ppu_stub, apu_stub);
+    typename vcpu::bus_type bus(ram, mapper, ppu_stub, apu_stub);
     vcpu cpu(bus);
+    cpu.trace() = std::move(trace);
+
+    // The reference log ends with the first instruction that starts at or after this cycle
+    constexpr typename vcpu::cycle_counter_type last_cycle = 26554;
+
+    cpu.set_pc(emu::absolute_address{0xC000});
+    cpu.run_until([](vcpu const& cpu) { return cpu.cycle_counter() >= last_cycle; });
+    cpu.step();
+
+    return std::move(cpu.trace());
+}
 
+void run_nes_cpu_test() {
     std::vector<std::string> execution_log;
-    cpu.set_exec_callback([&](vcpu const& cpu, vcpu::disasm_info const& info) {
+
+    emu::cpu::callback_trace trace;
+    trace.set_callback([&](emu::cpu::vcpu_state const& cpu, emu::cpu::disasm_info const& info) {
         std::string const regs = std::format("A:{:02X} X:{:02X} Y:{:02X} P:{:02X} SP:{:02X}", cpu.a(), cpu.x(), cpu.y(), cpu.flags().to_uint(), cpu.sp());
 
         std::string status = std::format("{:04X}  {:9s}{:31s}  {:s} CYC:{}", info.pc.to_uint(), info.bytes, info.instr_name + " " + info.operand, regs, cpu.cycle_counter());
         execution_log.push_back(std::move(status));
-
-        if (cpu.cycle_counter() >= 26554)
-            throw terminate_test();
     });
 
-    try {
-        cpu.run_at(emu::absolute_address{0xC000});
-    }
-    catch (terminate_test const&) {
-    }
+    run_nestest(std::move(trace));
 
     /*if (false)*/ {
         std::ofstream file("nestest_actual.log");
@@ -113,6 +141,25 @@ void run_nes_cpu_test() {
 
     if (!compare_logs(execution_log, expected_log))
         throw std::runtime_error("Test failed");
+
+    // Binary traces hold no memory values, so their records are compared with the logs without them
+    using binary_trace = emu::cpu::binary_trace<16384>;
+    binary_trace const records = run_nestest(binary_trace{});
+
+    std::vector<std::string> binary_log;
+    records.for_each([&](emu::cpu::trace_record const& record) {
+        binary_log.push_back(emu::cpu::to_string<nestest_cpu<binary_trace>>(record));
+    });
+
+    std::vector<std::string> stripped_log;
+    for (std::string const& line : expected_log)
+        stripped_log.push_back(strip_memory_values(line));
+
+    if (!compare_logs(binary_log, stripped_log))
+        throw std::runtime_error("Binary trace test failed");
+
+    if (!std::ranges::equal(binary_log, execution_log | std::views::transform(strip_memory_values)))
+        throw std::runtime_error("Binary trace doesn't match callback trace");
 }
 
 } // namespace emu::test
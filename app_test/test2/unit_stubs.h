@@ -12,6 +12,8 @@ public:
     void store(auto&&...) {}
 
     void store_oam_data_dma(auto&&) noexcept {}
+
+    void catch_up() noexcept {}
 };
 
 /** APU stub. */
@@ -22,4 +24,6 @@ public:
     }
 
     void store(auto&&...) {}
+
+    void catch_up() noexcept {}
 };
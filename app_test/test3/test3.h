@@ -0,0 +1,188 @@
+#pragma once
+
+#include "emu/address/abstract_address.h"
+#include "emu/apu/blip_buffer.h"
+#include "emu/apu/unit/channel_timer.h"
+#include "emu/apu/vapu.h"
+#include "emu/controller/vcontroller.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace emu::test {
+
+/** Controller with no buttons pressed. */
+class idle_controller : public vcontroller {};
+
+/** Checks that clocking a channel timer in bulk matches clocking it once per tick. */
+void check_timer_bulk_clocking(std::mt19937& rng) {
+    for (int run = 0; run < 10'000; ++run) {
+        apu::channel_timer bulk_timer;
+        apu::channel_timer tick_timer;
+
+        auto const period = static_cast<std::uint16_t>(rng() % 0x800);
+        bulk_timer.set_period(period);
+        tick_timer.set_period(period);
+
+        for (int step = 0; step < 20; ++step) {
+            std::uint32_t const ticks = rng() % 5000;
+
+            std::uint32_t const bulk_reloads = bulk_timer.clock(ticks);
+
+            std::uint32_t tick_reloads = 0;
+            for (std::uint32_t i = 0; i < ticks; ++i)
+                tick_reloads += tick_timer.clock();
+
+            if (bulk_reloads != tick_reloads || bulk_timer.value() != tick_timer.value())
+                throw std::runtime_error(std::format("Timer with period {} differs after {} ticks", period, ticks));
+
+            if (bulk_timer.ticks_until_reload() != tick_timer.ticks_until_reload())
+                throw std::runtime_error(std::format("Timer with period {} predicts a different reload", period));
+        }
+    }
+}
+
+/**
+ * Checks that stepping the APU in bulk produces the same output as stepping it one cycle at a time, with random
+ * register writes between the runs. Both APUs write their output to band-limited buffers, whose samples must match
+ * exactly, as must the status register and the DMC stall cycles.
+ */
+void check_apu_bulk_stepping(std::mt19937& rng) {
+    constexpr std::uint32_t cpu_clock = 1'789'773;
+    constexpr std::uint32_t sample_rate = 44'100;
+    constexpr std::size_t buffer_size = 4096;
+
+    constexpr auto registers = std::to_array<std::uint16_t>({
+        0x4000, 0x4001, 0x4002, 0x4003, 0x4004, 0x4005, 0x4006, 0x4007, 0x4008, 0x400A, 0x400B,
+        0x400C, 0x400E, 0x400F, 0x4010, 0x4011, 0x4012, 0x4013, 0x4015, 0x4017
+    });
+
+    constexpr auto status_register = abstract_address{0x4015};
+
+    // Sample bytes read by the DMC channel
+    auto const dma_reader = [](abstract_address addr) {
+        return static_cast<std::uint8_t>(addr.to_uint() * 0x9E37 >> 8);
+    };
+
+    idle_controller controller;
+
+    apu::vapu bulk_apu(controller);
+    apu::vapu cycle_apu(controller);
+    bulk_apu.set_dma_reader(dma_reader);
+    cycle_apu.set_dma_reader(dma_reader);
+
+    apu::blip_buffer bulk_buffer(cpu_clock, sample_rate, buffer_size);
+    apu::blip_buffer cycle_buffer(cpu_clock, sample_rate, buffer_size);
+    bulk_apu.set_output_buffer(&bulk_buffer);
+    cycle_apu.set_output_buffer(&cycle_buffer);
+
+    std::vector<float> bulk_samples(buffer_size);
+    std::vector<float> cycle_samples(buffer_size);
+
+    for (int run = 0; run < 2'000; ++run) {
+        for (std::uint32_t i = rng() % 4; i > 0; --i) {
+            auto const addr = abstract_address{registers[rng() % registers.size()]};
+            auto const value = static_cast<std::uint8_t>(rng());
+
+            bulk_apu.store(addr, value);
+            cycle_apu.store(addr, value);
+        }
+
+        std::uint32_t const cycles = rng() % 20'000;
+
+        bulk_apu.step(cycles);
+        for (std::uint32_t i = 0; i < cycles; ++i) {
+            cycle_apu.step(1);
+            cycle_apu.catch_up();
+        }
+
+        if (bulk_apu.output() != cycle_apu.output())
+            throw std::runtime_error(std::format("APU output differs after run {}", run));
+
+        if (bulk_apu.load(status_register) != cycle_apu.load(status_register))
+            throw std::runtime_error(std::format("APU status differs after run {}", run));
+
+        if (bulk_apu.take_stall_cycles() != cycle_apu.take_stall_cycles())
+            throw std::runtime_error(std::format("DMC stall cycles differ after run {}", run));
+
+        bulk_apu.end_block();
+        cycle_apu.end_block();
+
+        std::size_t const num_samples = bulk_buffer.read_samples(bulk_samples);
+        if (cycle_buffer.read_samples(cycle_samples) != num_samples
+                || !std::equal(bulk_samples.begin(), bulk_samples.begin() + num_samples, cycle_samples.begin()))
+            throw std::runtime_error(std::format("APU samples differ after run {}", run));
+    }
+}
+
+/** Checks that the samples of the channel buffers add up to the samples of the mixed output buffer. */
+void check_apu_channel_outputs(std::mt19937& rng) {
+    constexpr std::uint32_t cpu_clock = 1'789'773;
+    constexpr std::uint32_t sample_rate = 44'100;
+    constexpr std::size_t buffer_size = 4096;
+    constexpr float tolerance = 1e-4f;
+
+    constexpr auto registers = std::to_array<std::uint16_t>({
+        0x4000, 0x4002, 0x4003, 0x4004, 0x4006, 0x4007, 0x4008, 0x400A, 0x400B,
+        0x400C, 0x400E, 0x400F, 0x4010, 0x4011, 0x4012, 0x4013, 0x4015
+    });
+
+    idle_controller controller;
+    apu::vapu apu(controller);
+    apu.set_dma_reader([](abstract_address addr) { return static_cast<std::uint8_t>(addr.to_uint() * 0x9E37 >> 8); });
+
+    apu::blip_buffer mixed_buffer(cpu_clock, sample_rate, buffer_size);
+    apu.set_output_buffer(&mixed_buffer);
+
+    std::vector<apu::blip_buffer> channel_buffers;
+    for (std::size_t i = 0; i < apu::num_channels; ++i)
+        channel_buffers.emplace_back(cpu_clock, sample_rate, buffer_size);
+
+    for (std::size_t i = 0; i < apu::num_channels; ++i)
+        apu.set_channel_buffer(static_cast<apu::channel_id>(i), &channel_buffers[i]);
+
+    std::vector<float> mixed_samples(buffer_size);
+    std::vector<float> channel_samples(buffer_size);
+    std::vector<float> sum_samples(buffer_size);
+
+    for (int run = 0; run < 500; ++run) {
+        for (std::uint32_t i = rng() % 6; i > 0; --i)
+            apu.store(abstract_address{registers[rng() % registers.size()]}, static_cast<std::uint8_t>(rng()));
+
+        apu.step(rng() % 20'000);
+        apu.end_block();
+
+        std::size_t const num_samples = mixed_buffer.read_samples(mixed_samples);
+        std::fill(sum_samples.begin(), sum_samples.end(), 0.0f);
+
+        for (apu::blip_buffer& buffer : channel_buffers) {
+            if (buffer.read_samples(channel_samples) != num_samples)
+                throw std::runtime_error(std::format("Channel buffer sample count differs after run {}", run));
+
+            for (std::size_t i = 0; i < num_samples; ++i)
+                sum_samples[i] += channel_samples[i];
+        }
+
+        for (std::size_t i = 0; i < num_samples; ++i) {
+            if (std::abs(sum_samples[i] - mixed_samples[i]) > tolerance)
+                throw std::runtime_error(std::format("Channel outputs do not add up to the mix after run {}", run));
+        }
+    }
+}
+
+void run_apu_test() {
+    std::mt19937 rng(2024);
+
+    check_timer_bulk_clocking(rng);
+    check_apu_bulk_stepping(rng);
+    check_apu_channel_outputs(rng);
+}
+
+} // namespace emu::test
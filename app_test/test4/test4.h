@@ -0,0 +1,353 @@
+#pragma once
+
+#include "emu/address/abstract_address.h"
+#include "emu/constants.h"
+#include "emu/cpu/vcpu_state.h"
+#include "emu/mapper/mapper_000_nrom.h"
+#include "emu/ppu/frame_buffer.h"
+#include "emu/ppu/vppu.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace emu::test {
+
+using ppu_mapper = mapper::mapper_000_nrom;
+
+/** PPU whose internal state can be inspected and which can be advanced without rendering a deferred scanline. */
+class inspectable_ppu : public ppu::vppu<ppu_mapper> {
+public:
+    using vppu::vppu;
+
+    std::uint16_t scanline() const noexcept { return my_scanline.value(); }
+    std::uint16_t dot() const noexcept { return my_cycles.value(); }
+    std::uint16_t v() const noexcept { return my_v_reg.value(); }
+    std::uint8_t fine_x() const noexcept { return my_fine_x; }
+
+    bool is_sprite_zero_hit_set() const noexcept { return my_status_reg.is_sprite_zero_hit_set(); }
+    bool is_sprite_overflow_set() const noexcept { return my_status_reg.is_sprite_overflow_set(); }
+
+    /** Advances the PPU to the current cycle of the CPU, like a register read that does not observe the dot. */
+    void advance() {
+        step(my_cpu->cycle_counter() - my_synced_cycles);
+    }
+};
+
+/** A PPU along with the CPU cycle counter and the frame buffer it is connected to. */
+struct ppu_system {
+    ppu_system(std::vector<std::uint8_t> const& chr_rom) :
+        mapper(std::vector<std::uint8_t>(prg_rom_bank_size), chr_rom),
+        ppu(mapper, ppu::nametable_mirroring::vertical, image)
+    {
+        ppu.set_cpu(cpu);
+    }
+
+    cpu::vcpu_state cpu;
+    ppu_mapper mapper;
+    ppu::frame_buffer image;
+    inspectable_ppu ppu;
+};
+
+/** Fills the nametables, the palette and OAM with random data through PPU register writes, and turns rendering on. */
+template<class Store>
+void fill_ppu_memory(std::mt19937& rng, Store&& store) {
+    store(0x2001, 0x00);
+    store(0x2006, 0x20);
+    store(0x2006, 0x00);
+    for (std::uint16_t addr = 0x2000; addr < 0x3000; ++addr)
+        store(0x2007, static_cast<std::uint8_t>(rng()));
+
+    store(0x2006, 0x3F);
+    store(0x2006, 0x00);
+    for (std::uint16_t addr = 0x3F00; addr < 0x3F20; ++addr)
+        store(0x2007, static_cast<std::uint8_t>(rng() % 64));
+
+    // Sprite 0 is on screen; some sprites crowd a band of scanlines to overflow them
+    store(0x2003, 0x00);
+    for (std::uint16_t sprite = 0; sprite < ppu_oam_size / 4; ++sprite) {
+        auto const y = static_cast<std::uint8_t>(sprite % 3 == 0 ? 100 + rng() % 16 : rng() % 232);
+        store(0x2004, y);
+        store(0x2004, static_cast<std::uint8_t>(rng()));
+        store(0x2004, static_cast<std::uint8_t>(rng()));
+        store(0x2004, static_cast<std::uint8_t>(rng() % 248));
+    }
+
+    // Scroll to the top left corner of nametable 0; the $2006 writes above changed the scroll position
+    store(0x2000, 0x00);
+    store(0x2005, 0x00);
+    store(0x2005, 0x00);
+    store(0x2001, 0x1E);
+}
+
+/** Returns random CHR ROM data. */
+std::vector<std::uint8_t> make_chr_rom(std::mt19937& rng) {
+    std::vector<std::uint8_t> chr_rom(chr_rom_bank_size);
+    std::ranges::generate(chr_rom, [&] { return static_cast<std::uint8_t>(rng()); });
+
+    return chr_rom;
+}
+
+/**
+ * Checks that deferred scanline rendering gives the same results as rendering every dot. Both PPUs get the same
+ * random register accesses, e.g. mid-scanline scroll and mask writes. The reference PPU catches up after every CPU
+ * cycle, which renders any deferred scanline; the other PPU only catches up on register accesses. The frame images,
+ * the values read, and v, fine X and the sprite flags at the end of every visible scanline must match.
+ */
+void check_deferred_rendering(std::mt19937& rng, std::uint32_t accesses_per_mille, int num_frames) {
+    std::vector<std::uint8_t> const chr_rom = make_chr_rom(rng);
+
+    ppu_system deferred(chr_rom);
+    ppu_system reference(chr_rom);
+
+    auto const store = [&](std::uint16_t addr, std::uint8_t value) {
+        deferred.ppu.store(abstract_address{addr}, value);
+        reference.ppu.store(abstract_address{addr}, value);
+    };
+
+    fill_ppu_memory(rng, store);
+
+    auto const load = [&](std::uint16_t addr) {
+        std::uint8_t const deferred_value = deferred.ppu.load(abstract_address{addr});
+        std::uint8_t const reference_value = reference.ppu.load(abstract_address{addr});
+        if (deferred_value != reference_value)
+            throw std::runtime_error(std::format("Reading ${:04X} at scanline {}, dot {} returns ${:02X} instead of "
+                "${:02X}", addr, reference.ppu.scanline(), reference.ppu.dot(), deferred_value, reference_value));
+    };
+
+    // Mostly full rendering; sometimes without background, sprites or the left 8 pixels, or with rendering off
+    auto const random_mask = [&] {
+        return static_cast<std::uint8_t>(rng() % 4 == 0 ? rng() : 0x1E);
+    };
+
+    int frame = 0;
+    std::uint16_t last_checked_line = 0xFFFF;
+    while (frame < num_frames) {
+        deferred.cpu.advance_cycle_counter();
+        reference.cpu.advance_cycle_counter();
+        reference.ppu.catch_up();
+
+        if (rng() % 1000 < accesses_per_mille) {
+            switch (rng() % 16) {
+            case 0: case 1: case 2: case 3: case 4:
+                load(0x2002);
+                break;
+
+            case 5: case 6: case 7:
+                store(0x2005, static_cast<std::uint8_t>(rng()));
+                break;
+
+            case 8: case 9:
+                store(0x2001, random_mask());
+                break;
+
+            case 10:
+                store(0x2000, static_cast<std::uint8_t>(rng() & 0x3B));
+                break;
+
+            case 11:
+                store(0x2006, static_cast<std::uint8_t>(rng()));
+                break;
+
+            case 12:
+                load(0x2004);
+                break;
+
+            case 13:
+                load(0x2007);
+                break;
+
+            case 14:
+                store(0x2003, static_cast<std::uint8_t>(rng()));
+                break;
+
+            case 15:
+                store(0x2004, static_cast<std::uint8_t>(rng()));
+            }
+        }
+
+        std::uint16_t const line = reference.ppu.scanline();
+        std::uint16_t const dot = reference.ppu.dot();
+
+        // A deferred scanline is rendered with dot 257, the first dot after its visible part
+        if (line < ppu::frame_buffer::height && dot > 257 && line != last_checked_line) {
+            last_checked_line = line;
+            deferred.ppu.advance();
+
+            if (deferred.ppu.dot() != dot || deferred.ppu.v() != reference.ppu.v() ||
+                deferred.ppu.fine_x() != reference.ppu.fine_x())
+                throw std::runtime_error(std::format("Scanline {} ends at v=${:04X}, fine X {} instead of v=${:04X}, "
+                    "fine X {}", line, deferred.ppu.v(), deferred.ppu.fine_x(), reference.ppu.v(),
+                    reference.ppu.fine_x()));
+
+            if (deferred.ppu.is_sprite_zero_hit_set() != reference.ppu.is_sprite_zero_hit_set() ||
+                deferred.ppu.is_sprite_overflow_set() != reference.ppu.is_sprite_overflow_set())
+                throw std::runtime_error(std::format("Sprite flags differ at the end of scanline {}", line));
+        }
+
+        // The frame is released at dot 1 of scanline 241
+        if (line == 241 && dot >= 2 && last_checked_line != line) {
+            last_checked_line = line;
+            deferred.ppu.advance();
+
+            if (!std::ranges::equal(deferred.image.acquire(), reference.image.acquire(), [](auto a, auto b) {
+                    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+                }))
+                throw std::runtime_error(std::format("Frame {} differs", frame));
+
+            ++frame;
+        }
+    }
+}
+
+/** Runs a PPU until it has released the next frame, which is at dot 1 of scanline 241. */
+void run_to_next_frame(ppu_system& system) {
+    auto const step = [&] {
+        system.cpu.advance_cycle_counter();
+        system.ppu.advance();
+    };
+
+    do step(); while (system.ppu.scanline() == 241);
+    do step(); while (system.ppu.scanline() != 241 || system.ppu.dot() < 2);
+}
+
+/** Returns the set of scanlines [first, first + count). */
+ppu::frame_buffer::row_mask scanline_rows(std::uint16_t first, std::uint16_t count) {
+    ppu::frame_buffer::row_mask rows;
+    for (std::uint16_t row = first; row < first + count; ++row)
+        rows.set(row);
+
+    return rows;
+}
+
+/**
+ * Checks the rows the frame buffer reports as changed (see frame_buffer::changed_rows()) after changes made in
+ * v-blank: none for a static frame, the tile rows a nametable or attribute byte shows, all rows for palette, OAM and
+ * scroll changes, and the union of both frames' rows for two frames released without acquire() in between. Frames
+ * skipped by the render interval keep the frame to compare with; a render mode switch does not.
+ */
+void check_changed_rows(std::mt19937& rng) {
+    ppu_system system(make_chr_rom(rng));
+
+    auto const store = [&](std::uint16_t addr, std::uint8_t value) {
+        system.ppu.store(abstract_address{addr}, value);
+    };
+
+    auto const load = [&](std::uint16_t addr) {
+        return system.ppu.load(abstract_address{addr});
+    };
+
+    // Changes a byte of VRAM, then restores the scroll position that $2006 overwrites
+    auto const modify_vram = [&](std::uint16_t addr) {
+        store(0x2006, static_cast<std::uint8_t>(addr >> 8));
+        store(0x2006, static_cast<std::uint8_t>(addr));
+        if (addr < 0x3F00)
+            load(0x2007);  // Reads below the palette return the read buffer first
+
+        std::uint8_t const value = load(0x2007);
+        store(0x2006, static_cast<std::uint8_t>(addr >> 8));
+        store(0x2006, static_cast<std::uint8_t>(addr));
+        store(0x2007, value ^ 1);
+
+        store(0x2000, 0x00);
+        store(0x2005, 0x00);
+        store(0x2005, 0x00);
+    };
+
+    auto const expect_rows = [&](char const* change, ppu::frame_buffer::row_mask const& expected) {
+        system.image.acquire();
+        ppu::frame_buffer::row_mask const& changed = system.image.changed_rows();
+        if (changed != expected)
+            throw std::runtime_error(std::format("{} reports {} changed rows instead of {}", change, changed.count(),
+                expected.count()));
+    };
+
+    ppu::frame_buffer::row_mask const all_rows = ppu::frame_buffer::row_mask{}.set();
+    ppu::frame_buffer::row_mask const no_rows = {};
+
+    fill_ppu_memory(rng, store);
+    for (int frame = 0; frame < 3; ++frame)
+        run_to_next_frame(system);
+
+    system.image.acquire();
+    run_to_next_frame(system);
+    expect_rows("A static frame", no_rows);
+
+    modify_vram(0x2000 + 10 * 32 + 5);  // Tile row 10
+    run_to_next_frame(system);
+    expect_rows("A nametable byte", scanline_rows(80, 8));
+
+    modify_vram(0x23C0 + 2 * 8 + 3);  // Tile rows 8-11
+    run_to_next_frame(system);
+    expect_rows("An attribute byte", scanline_rows(64, 32));
+
+    modify_vram(0x3F05);
+    run_to_next_frame(system);
+    expect_rows("A palette entry", all_rows);
+
+    std::array<std::uint8_t, ppu_oam_size> oam;
+    std::ranges::generate(oam, [&] { return static_cast<std::uint8_t>(rng()); });
+    system.ppu.store_oam_data_dma(oam);
+    run_to_next_frame(system);
+    expect_rows("OAM DMA", all_rows);
+
+    store(0x2005, 0x08);
+    store(0x2005, 0x00);
+    run_to_next_frame(system);
+    expect_rows("A scroll change", all_rows);
+
+    run_to_next_frame(system);
+    expect_rows("A static frame after a scroll change", no_rows);
+
+    store(0x2005, 0x00);
+    store(0x2005, 0x00);
+    run_to_next_frame(system);
+    expect_rows("Scrolling back", all_rows);
+
+    modify_vram(0x2000 + 3 * 32);  // Tile row 3, released but not acquired
+    run_to_next_frame(system);
+    modify_vram(0x2000 + 20 * 32);  // Tile row 20
+    run_to_next_frame(system);
+    expect_rows("Two frames released at once", scanline_rows(24, 8) | scanline_rows(160, 8));
+
+    system.ppu.set_render_interval(2);
+    for (int frame = 0; frame < 4; ++frame) {
+        run_to_next_frame(system);
+        expect_rows("A static frame with a render interval", no_rows);
+    }
+
+    // Whether the next frame is rendered is decided when the previous one is released, so a render mode set in
+    // v-blank applies from the frame after the next one
+    system.ppu.set_render_interval(1);
+    system.ppu.set_render_mode(ppu::render_mode::none);
+    for (int frame = 0; frame < 3; ++frame)
+        run_to_next_frame(system);
+
+    expect_rows("Frames without rendering", no_rows);
+
+    system.ppu.set_render_mode(ppu::render_mode::full);
+    run_to_next_frame(system);
+    run_to_next_frame(system);
+    expect_rows("The first frame rendered after a render mode switch", all_rows);
+
+    run_to_next_frame(system);
+    expect_rows("A static frame after a render mode switch", no_rows);
+}
+
+void run_ppu_test() {
+    std::mt19937 rng(2024);
+
+    for (int run = 0; run < 4; ++run) {
+        check_deferred_rendering(rng, 2, 10);
+        check_deferred_rendering(rng, 10, 10);
+    }
+
+    check_changed_rows(rng);
+}
+
+} // namespace emu::test
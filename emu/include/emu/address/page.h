@@ -10,4 +10,7 @@ enum class page_index : std::uint8_t {};
 /** Size of a single memory page, in bytes. */
 inline constexpr std::uint16_t page_size = 0x0100;
 
+/** Write generation of a memory page (see page_generation() of the buses); 64 bits wide so that it never wraps. */
+using page_generation_type = std::uint64_t;
+
 } // namespace emu
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace emu::apu {
+
+/**
+ * Band-limited synthesis buffer. Converts amplitude changes (deltas) at CPU-cycle timestamps into samples at the
+ * output sample rate. Each delta is added as a windowed-sinc step, so the output contains no frequencies above the
+ * Nyquist limit and does not alias.
+ *
+ * Deltas are added within a block, timed in clocks relative to the start of the block. Ending the block makes the
+ * samples up to its end available for reading; samples not read stay available for the next block.
+ */
+class blip_buffer {
+public:
+    /** Creates a buffer converting from a clock rate to a sample rate, holding at most max_samples samples. */
+    blip_buffer(std::uint32_t clock_rate, std::uint32_t sample_rate, std::size_t max_samples);
+
+    /**
+     * Changes the sample rate, which may be fractional. Deltas added from then on use the new rate, so it should
+     * only change between blocks, before the first delta of the next block.
+     */
+    void set_sample_rate(double sample_rate) noexcept;
+
+    /** Adds an amplitude change at a clock time relative to the start of the current block. */
+    void add_delta(std::uint32_t clock_time, float delta) noexcept;
+
+    /** Returns the number of clocks the current block must last until the given number of samples is available. */
+    std::uint32_t clocks_needed(std::size_t num_samples) const noexcept;
+
+    /** Ends the current block at a clock time and starts a new one there. */
+    void end_block(std::uint32_t clock_time) noexcept;
+
+    /** Returns the number of samples that can be read. */
+    std::size_t samples_available() const noexcept;
+
+    /** Reads samples into the span, fewer if not as many are available, and returns the number of samples read. */
+    std::size_t read_samples(std::span<float>) noexcept;
+
+public:
+    static constexpr std::size_t kernel_size = 16;   // Samples affected by a delta
+    static constexpr std::size_t phase_bits  = 5;
+    static constexpr std::size_t num_phases  = std::size_t{1} << phase_bits;  // Kernels per sample interval
+
+private:
+    /** Sample positions are fixed-point numbers with time_bits fraction bits. */
+    static constexpr unsigned time_bits = 32;
+    static constexpr std::uint64_t time_unit = std::uint64_t{1} << time_bits;
+
+    std::uint32_t my_clock_rate;
+    std::uint64_t my_factor;      // Samples per clock
+    std::uint64_t my_offset = 0;  // Position of the start of the current block
+
+    std::vector<float> my_deltas;  // Sum of the kernels added at each sample
+    float my_integrator = 0;       // Output amplitude before the first sample in the buffer
+};
+
+} // namespace emu::apu
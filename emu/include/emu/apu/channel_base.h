@@ -3,6 +3,9 @@
 #include "emu/apu/unit/channel_timer.h"
 #include "emu/apu/unit/length_counter.h"
 
+#include <cstdint>
+#include <limits>
+
 namespace emu::apu {
 
 /**
@@ -22,6 +25,9 @@ public:
     /** Clocks the length counter. */
     void clock_length() noexcept;
 
+    /** Returned by ticks_until_step() of a channel whose output a waveform step cannot change. */
+    static constexpr std::uint32_t no_step = std::numeric_limits<std::uint32_t>::max();
+
 protected:
     channel_base() = default;
 
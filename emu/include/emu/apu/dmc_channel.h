@@ -0,0 +1,116 @@
+#pragma once
+
+#include "emu/address.h"
+#include "emu/apu/channel_base.h"
+#include "emu/apu/unit/channel_timer.h"
+
+#include <cstdint>
+#include <functional>
+
+namespace emu::apu {
+
+/**
+ * Delta modulation channel. Plays 1-bit delta-encoded samples that it fetches from CPU memory by DMA, one byte at a
+ * time; each fetch stalls the CPU. The timer is clocked at the CPU rate.
+ */
+class dmc_channel {
+public:
+    /** Reads a sample byte from CPU memory. */
+    using memory_reader = std::function<std::uint8_t(abstract_address)>;
+
+    /** Number of CPU cycles a sample fetch stalls the CPU (the common case of a fetch during a CPU read). */
+    static constexpr std::uint32_t dma_stall_cycles = 4;
+
+    dmc_channel();
+
+    /** Returns the current output of the channel (0-127). */
+    std::uint8_t output() const noexcept;
+
+    /** Returns true if sample bytes remain to be fetched. */
+    bool is_active() const noexcept;
+
+    /** Returns true if the channel raises an IRQ. */
+    bool is_irq_set() const noexcept;
+
+    /** Acknowledges the IRQ. */
+    void clear_irq() noexcept;
+
+    /** Enables the channel, restarting the sample if it has ended, or disables it, ending the sample. */
+    void enable(bool) noexcept;
+
+    /** Sets the function that reads sample bytes from CPU memory. */
+    void set_memory_reader(memory_reader) noexcept;
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Channel configuration
+
+    /** Writes a byte to the control register ($4010). */
+    void store_control(std::uint8_t) noexcept;
+
+    /** Writes a byte to the direct load register ($4011). */
+    void store_output_level(std::uint8_t) noexcept;
+
+    /** Writes a byte to the sample address register ($4012). */
+    void store_sample_address(std::uint8_t) noexcept;
+
+    /** Writes a byte to the sample length register ($4013). */
+    void store_sample_length(std::uint8_t) noexcept;
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Channel clocks
+
+    /** Clocks the timer for a number of CPU cycles. */
+    void clock_timer(std::uint32_t cpu_cycles) noexcept;
+
+    /** Returns the number of CPU cycles until the output unit next clocks, or no_step if the output cannot change. */
+    std::uint32_t ticks_until_step() const noexcept;
+
+    /** Returns the number of CPU cycles until the next sample fetch, or no_step if no fetch is due. */
+    std::uint32_t ticks_until_fetch() const noexcept;
+
+    /** Returns the CPU cycles the sample fetches stalled the CPU since the last call. */
+    std::uint32_t take_stall_cycles() noexcept;
+
+    /** Returns true if sample fetches stalled the CPU since the last call to take_stall_cycles(). */
+    bool has_stall_cycles() const noexcept {
+        return my_stall_cycles > 0;
+    }
+
+private:
+    /** Clocks the output unit: applies a delta bit and loads the next sample byte after the last bit. */
+    void clock_output() noexcept;
+
+    /** Fetches the next sample byte into the empty sample buffer, if any bytes remain. */
+    void fill_sample_buffer() noexcept;
+
+    /** Restarts the sample from its start address. */
+    void restart() noexcept;
+
+    static std::uint16_t period(std::uint8_t rate_index) noexcept;
+
+private:
+    channel_timer my_timer;
+    memory_reader my_memory_reader;
+
+    bool my_irq_enabled = false;
+    bool my_loop_enabled = false;
+    bool my_irq = false;
+
+    std::uint16_t my_sample_address = 0xC000;
+    std::uint16_t my_sample_length = 1;
+    std::uint16_t my_current_address = 0xC000;
+    std::uint16_t my_bytes_remaining = 0;
+
+    std::uint8_t my_sample_buffer = 0;
+    bool my_sample_buffer_empty = true;
+
+    std::uint8_t my_shift_register = 0;
+    std::uint8_t my_bits_remaining = 8;
+    bool my_silence = true;
+
+    std::uint8_t my_output_level = 0;
+
+    std::uint32_t my_stall_cycles = 0;
+};
+
+} // namespace emu::apu
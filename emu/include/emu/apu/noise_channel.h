@@ -27,8 +27,11 @@ public:
     ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     // Channel clocks
 
-    /** Clocks the timer. */
-    void clock_timer() noexcept;
+    /** Clocks the timer a number of times. */
+    void clock_timer(std::uint32_t ticks) noexcept;
+
+    /** Returns the number of timer clocks until the waveform next steps, or no_step if the step cannot be heard. */
+    std::uint32_t ticks_until_step() const noexcept;
 
     /** Clocks the envelope unit. */
     void clock_envelope() noexcept;
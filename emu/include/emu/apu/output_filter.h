@@ -0,0 +1,48 @@
+#pragma once
+
+#include <span>
+
+namespace emu::apu {
+
+/**
+ * Models the analog output stages of the NES: two first-order high-pass filters (90 Hz and 440 Hz) followed by a
+ * first-order low-pass filter (14 kHz). The high-pass filters remove the DC offset of the mixer, so the output is
+ * centered at 0.
+ */
+class output_filter {
+public:
+    /** Creates the filters for a sample rate. */
+    explicit output_filter(double sample_rate) noexcept;
+
+    /** Filters a block of samples in place, continuing from the previous block. */
+    void process(std::span<float>) noexcept;
+
+private:
+    struct high_pass {
+        float coefficient;
+        float last_input = 0;
+        float last_output = 0;
+
+        float apply(float input) noexcept {
+            last_output = coefficient * (last_output + input - last_input);
+            last_input = input;
+            return last_output;
+        }
+    };
+
+    struct low_pass {
+        float coefficient;
+        float last_output = 0;
+
+        float apply(float input) noexcept {
+            last_output += coefficient * (input - last_output);
+            return last_output;
+        }
+    };
+
+    high_pass my_high_pass_90;
+    high_pass my_high_pass_440;
+    low_pass  my_low_pass_14k;
+};
+
+} // namespace emu::apu
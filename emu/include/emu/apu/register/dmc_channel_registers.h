@@ -0,0 +1,77 @@
+#pragma once
+
+#include "emu/utility/bit_flags.h"
+
+#include <cstdint>
+
+namespace emu::apu {
+
+/**
+ * APU DMC channel control register ($4010, write only).
+ */
+class dmc_control_register : private bit_flags<std::uint8_t> {
+public:
+    using bit_flags::bit_flags;
+
+    /** Returns true if the channel raises an IRQ when a sample ends without looping. */
+    bool is_irq_enabled() const noexcept;
+
+    /** Returns true if the sample restarts when it ends. */
+    bool is_loop_enabled() const noexcept;
+
+    /** Returns the rate index into the table of output periods. */
+    std::uint8_t rate_index() const noexcept;
+
+private:
+    enum class flags : underlying_type {
+        rate_index = 0b0000'1111,  // Output period index
+        loop       = 0b0100'0000,  // 1 = Loop the sample
+        irq_enable = 0b1000'0000   // 1 = Raise an IRQ when the sample ends
+    };
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * APU DMC channel direct load register ($4011, write only).
+ */
+class dmc_load_register : private bit_flags<std::uint8_t> {
+public:
+    using bit_flags::bit_flags;
+
+    /** Returns the 7-bit output level. */
+    std::uint8_t output_level() const noexcept;
+
+private:
+    enum class flags : underlying_type {
+        output_level = 0b0111'1111
+    };
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * APU DMC channel sample address register ($4012, write only).
+ */
+class dmc_sample_address_register : private bit_flags<std::uint8_t> {
+public:
+    using bit_flags::bit_flags;
+
+    /** Returns the address of the first sample byte, $C000-$FFC0 in steps of 64 bytes. */
+    std::uint16_t sample_address() const noexcept;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * APU DMC channel sample length register ($4013, write only).
+ */
+class dmc_sample_length_register : private bit_flags<std::uint8_t> {
+public:
+    using bit_flags::bit_flags;
+
+    /** Returns the sample length in bytes, 1-4081 in steps of 16 bytes. */
+    std::uint16_t sample_length() const noexcept;
+};
+
+} // namespace emu::apu
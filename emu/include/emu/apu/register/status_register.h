@@ -26,6 +26,9 @@ public:
     /** Returns whether the noise channel is enabled. */
     bool is_noise_channel_enabled() const noexcept;
 
+    /** Returns whether the DMC channel is enabled. */
+    bool is_dmc_channel_enabled() const noexcept;
+
     /** Sets pulse channel 1 state as active. */
     void set_pulse1_channel_active(bool) noexcept;
 
@@ -38,13 +41,20 @@ public:
     /** Sets the noise channel state as active. */
     void set_noise_channel_active(bool) noexcept;
 
+    /** Sets the DMC channel state as active. */
+    void set_dmc_channel_active(bool) noexcept;
+
+    /** Sets the DMC interrupt flag. */
+    void set_dmc_interrupt(bool) noexcept;
+
 private:
     enum class flags : underlying_type {
         pulse1_channel   = 0b0000'0001,  // Enable/active pulse channel 1 flag
         pulse2_channel   = 0b0000'0010,  // Enable/active pulse channel 2 flag
         triangle_channel = 0b0000'0100,  // Enable/active triangle channel flag
         noise_channel    = 0b0000'1000,  // Enable/active noise channel flag
-        dmc_channel      = 0b0001'0000   // Enable/active DMC channel flag
+        dmc_channel      = 0b0001'0000,  // Enable/active DMC channel flag
+        dmc_interrupt    = 0b1000'0000   // DMC interrupt flag (read only)
     };
 };
 
@@ -32,8 +32,11 @@ public:
     ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     // Channel clocks
 
-    /** Clocks the timer. */
-    void clock_timer();
+    /** Clocks the timer a number of times. */
+    void clock_timer(std::uint32_t ticks) noexcept;
+
+    /** Returns the number of timer clocks until the waveform next steps, or no_step if the step cannot be heard. */
+    std::uint32_t ticks_until_step() const noexcept;
 
     /** Clocks the linear counter. */
     void clock_linear_counter() noexcept;
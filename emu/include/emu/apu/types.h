@@ -2,6 +2,7 @@
 
 #include "emu/utility/cyclic_counter.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <variant>
 
@@ -9,6 +10,17 @@ namespace emu::apu {
 
 enum class duty_mode : std::uint8_t {};
 
+/** Sound channels of the APU. */
+enum class channel_id : std::uint8_t {
+    pulse1,
+    pulse2,
+    triangle,
+    noise,
+    dmc
+};
+
+constexpr std::size_t num_channels = 5;
+
 /** Length counter index (5-bit value, valid range: 0-31). */
 enum class length_counter_index : std::uint8_t {};
 
@@ -17,6 +17,11 @@ public:
         return my_counter;
     }
 
+    /** Returns the number of clocks until the timer next reloads. */
+    std::uint32_t ticks_until_reload() const noexcept {
+        return my_counter + 1u;
+    }
+
     void set_period(std::uint16_t period) {
         my_period = period;
     }
@@ -29,15 +34,22 @@ public:
         my_period = (my_period & 0x00FF) | (period_hi_byte << 8);
     }
 
-    bool clock() {
-        if (my_counter == 0) {
-            my_counter = my_period;
-            return true;
-        }
-        else {
-            --my_counter;
-            return false;
+    /**
+     * Clocks the timer a number of times and returns how many times it reached zero and reloaded. The counter is
+     * decremented on each clock and reloaded with the period on the clock after it reached zero.
+     */
+    std::uint32_t clock(std::uint32_t ticks = 1) noexcept {
+        if (ticks <= my_counter) {
+            my_counter -= static_cast<std::uint16_t>(ticks);
+            return 0;
         }
+
+        // The first reload takes (counter + 1) ticks, each further reload (period + 1) ticks
+        ticks -= my_counter + 1u;
+        std::uint32_t const reload_interval = my_period + 1u;
+
+        my_counter = static_cast<std::uint16_t>(my_period - ticks % reload_interval);
+        return 1 + ticks / reload_interval;
     }
 
 private:
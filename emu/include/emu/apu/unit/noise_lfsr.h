@@ -23,8 +23,8 @@ public:
     /** Sets the LFSR feedback mode. */
     void set_mode(noise_lfsr_mode) noexcept;
 
-    /** Advances the shift register. */
-    void advance() noexcept;
+    /** Advances the shift register a number of times. */
+    void advance(std::uint32_t count = 1) noexcept;
 
 private:
     std::uint16_t   my_state = 1;
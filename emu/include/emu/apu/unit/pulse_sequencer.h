@@ -21,8 +21,8 @@ public:
     /** Resets the sequencer to index 0. */
     void reset() noexcept;
 
-    /** Advances the sequencer by one step. */
-    void clock() noexcept;
+    /** Advances the sequencer by a number of steps. */
+    void clock(std::uint32_t count = 1) noexcept;
 
 private:
     static constexpr std::uint8_t num_modes = 4;
@@ -14,8 +14,8 @@ public:
     /** Returns the current sequencer output value. */
     std::uint8_t output() const noexcept;
 
-    /** Advances the sequencer by one step. */
-    void clock() noexcept;
+    /** Advances the sequencer by a number of steps. */
+    void clock(std::uint32_t count = 1) noexcept;
 
 private:
     static constexpr std::uint8_t num_steps = 32;
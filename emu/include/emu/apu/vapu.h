@@ -1,6 +1,8 @@
 #pragma once
 
 #include "emu/address.h"
+#include "emu/apu/blip_buffer.h"
+#include "emu/apu/dmc_channel.h"
 #include "emu/apu/noise_channel.h"
 #include "emu/apu/pulse_channel.h"
 #include "emu/apu/triangle_channel.h"
@@ -8,8 +10,11 @@
 #include "emu/fwd.h"
 #include "emu/utility/cyclic_counter.h"
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 
 namespace emu::apu {
 
@@ -20,36 +25,125 @@ public:
     /** Returns the current output of the APU in the range [0, 1]. */
     float output();
 
+    /**
+     * Sets the buffer that receives the output as band-limited amplitude changes (nullptr for none). Changes are
+     * timed in CPU cycles from the start of the current block; see end_block().
+     */
+    void set_output_buffer(blip_buffer*) noexcept;
+
+    /**
+     * Sets a buffer that receives the share of a single channel in the mixed output (nullptr for none); see
+     * channel_outputs(). The shares of all channels add up to the mixed output.
+     */
+    void set_channel_buffer(channel_id, blip_buffer*) noexcept;
+
+    /** Returns the number of CPU cycles the APU was stepped since the start of the current block. */
+    std::uint64_t block_cycles() const noexcept {
+        return my_block_cycles + my_pending_cycles;
+    }
+
+    /** Ends the current block of the output and channel buffers at the current cycle and starts a new one. */
+    void end_block() noexcept;
+
     /** Reads a byte from an APU register. */
     std::uint8_t load(abstract_address) noexcept;
 
     /** Writes a byte to an APU register. */
     void store(abstract_address, std::uint8_t) noexcept;
 
-    void step(std::uint64_t cpu_cycles) {
-        for (std::uint64_t i = 0; i < cpu_cycles; ++i)
-        {
-            if (my_odd_cycle)
-            {
-                my_pulse1_channel.clock_timer();
-                my_pulse2_channel.clock_timer();
-                my_noise_channel.clock_timer();
-            }
-            my_odd_cycle = !my_odd_cycle;
-
-            my_triangle_channel.clock_timer();
-            if (frame_counter0.increment())
-                step_frame_counter();
-        }
+    /**
+     * Advances the APU by a number of CPU cycles. The cycles are only accumulated; the APU catches up when its
+     * output is sampled or a register is accessed (see catch_up()).
+     */
+    void step(std::uint64_t cpu_cycles) noexcept {
+        my_pending_cycles += cpu_cycles;
+        my_cycle_counter += cpu_cycles;
     }
 
+    /**
+     * Advances the APU by the cycles accumulated by step(). Channel timers are clocked in bulk between frame counter
+     * steps, the only events that change channel state without a register write, so the result is the same as
+     * clocking every cycle. With an output buffer, the runs also end at each audible waveform step.
+     */
+    void catch_up() noexcept;
+
+    /** Sets the function through which the DMC channel fetches sample bytes from CPU memory. */
+    void set_dma_reader(dmc_channel::memory_reader) noexcept;
+
+    /**
+     * Returns the number of CPU cycles the APU can be stepped until the DMC channel next fetches a sample byte, 0 if
+     * the fetch is due. Fetches stall the CPU; see take_stall_cycles(). A silent DMC channel never fetches.
+     */
+    std::uint64_t cycles_until_dma() const noexcept {
+        return my_dma_cycle - std::min(my_dma_cycle, my_cycle_counter);
+    }
+
+    /** Catches up and returns the CPU cycles DMC sample fetches stalled the CPU since the last call. */
+    std::uint64_t take_stall_cycles() noexcept;
+
+    /** Returns true if the APU asserts the CPU IRQ line (DMC interrupt). */
+    bool is_irq_asserted() noexcept;
+
 private:
+    /** Returns the output of the channels mixed into the range [0, 1]. */
+    float mix() noexcept;
+
+    /**
+     * Returns the share of each channel in the mixed output. The mixer is nonlinear within its pulse and TND groups,
+     * so the output of each group is divided among its channels in proportion to their weighted levels.
+     */
+    std::array<float, num_channels> channel_outputs() noexcept;
+
+    /** Returns true if any output or channel buffer is set. */
+    bool has_buffers() const noexcept {
+        return my_output_buffer || my_num_channel_buffers > 0;
+    }
+
+    /** Returns the number of CPU cycles until the next audible waveform step of any channel. */
+    std::uint64_t cycles_until_waveform_step() const noexcept;
+
+    /** Adds the changes of the mixed and channel outputs since the last update to the buffers. */
+    void update_output() noexcept;
+
+    /** Clocks the channel timers for a number of CPU cycles; the triangle timer runs at twice the rate of others. */
+    void clock_timers(std::uint32_t cpu_cycles) noexcept;
+
+    /** Updates the cycle of the next DMC sample fetch; see cycles_until_dma(). */
+    void schedule_dma() noexcept;
+
+    /** Register access handlers; see load() and store(). */
+    using load_fn_ptr  = std::uint8_t (vapu::*)() noexcept;
+    using store_fn_ptr = void (vapu::*)(std::uint8_t) noexcept;
+
+    /** Returns the index of a register in the APU and I/O range $4000-$401F. */
+    static constexpr std::size_t register_index(abstract_address addr) noexcept {
+        return addr.to_uint() & (num_registers - 1);
+    }
+
     /** Reads data from the status register. */
-    std::uint8_t load_status() const noexcept;
+    std::uint8_t load_status() noexcept;
 
     /** Writes data into the status register. */
     void store_status(std::uint8_t) noexcept;
 
+    /** Writes a channel register; Channel selects the channel member and Store the channel's store function. */
+    template<auto Channel, auto Store>
+    void store_channel(std::uint8_t value) noexcept {
+        ((this->*Channel).*Store)(value);
+    }
+
+    /** Reads data from the controller port. */
+    std::uint8_t load_controller() noexcept;
+
+    /** Writes data to the controller strobe register. */
+    void store_controller(std::uint8_t) noexcept;
+
+    /** Reads an unmapped or write-only register. */
+    std::uint8_t load_unmapped() noexcept;
+
+    /** Writes an unmapped or read-only register, which has no effect. */
+    void store_unmapped(std::uint8_t) noexcept;
+
     /** Writes data into the frame counter register. */
     void store_frame_counter(std::uint8_t) noexcept;
 
@@ -78,11 +172,17 @@ private:
     static constexpr auto apu_noise_ctrl_register   = abstract_address{0x400C};  // Write only
     static constexpr auto apu_noise_mode_register   = abstract_address{0x400E};  // Write only
     static constexpr auto apu_noise_timer_register  = abstract_address{0x400F};  // Write only
+    static constexpr auto apu_dmc_ctrl_register     = abstract_address{0x4010};  // Write only
+    static constexpr auto apu_dmc_load_register     = abstract_address{0x4011};  // Write only
+    static constexpr auto apu_dmc_address_register  = abstract_address{0x4012};  // Write only
+    static constexpr auto apu_dmc_length_register   = abstract_address{0x4013};  // Write only
     static constexpr auto apu_status_register       = abstract_address{0x4015};  // Write only
     static constexpr auto apu_ctrl1_register        = abstract_address{0x4016};  // Read/Write
     static constexpr auto apu_ctrl2_register        = abstract_address{0x4017};  // Read only
     static constexpr auto apu_fc_register           = abstract_address{0x4017};  // Write only
 
+    static constexpr std::size_t num_registers = 0x20;  // $4000-$401F
+
 private:
     static constexpr std::uint16_t cycles_per_frame = 7'457;
     cyclic_counter<std::uint16_t, cycles_per_frame> frame_counter0;
@@ -91,8 +191,20 @@ private:
     pulse_channel    my_pulse2_channel;
     triangle_channel my_triangle_channel;
     noise_channel    my_noise_channel;
+    dmc_channel      my_dmc_channel;
 
     bool my_odd_cycle = false;
+    std::uint64_t my_pending_cycles = 0;  // CPU cycles passed to step() but not yet processed
+    std::uint64_t my_cycle_counter = 0;   // CPU cycles passed to step()
+    std::uint64_t my_dma_cycle = std::numeric_limits<std::uint64_t>::max();  // Cycle of the next DMC sample fetch
+
+    blip_buffer*  my_output_buffer = nullptr;
+    std::uint64_t my_block_cycles = 0;  // CPU cycles processed since the start of the current block
+    float         my_amplitude = 0;     // Mixed output last added to the output buffer
+
+    std::array<blip_buffer*, num_channels> my_channel_buffers = {};
+    std::array<float, num_channels>        my_channel_amplitudes = {};  // Outputs last added to the channel buffers
+    std::size_t                            my_num_channel_buffers = 0;
 
     vcontroller& my_controller;
     frame_sequencer my_frame_sequencer;
@@ -21,7 +21,7 @@ public:
 
     /** Writes a 16-bit word to memory or a device register. */
     template<class Self, class Address>
-    void store_word(this Self const& self, Address addr, std::uint16_t value) {
+    void store_word(this Self& self, Address addr, std::uint16_t value) {
         std::uint8_t const lo_byte = get_lo_byte(value);
         self.store(addr,     lo_byte);
 
@@ -1,13 +1,16 @@
 #pragma once
 
 #include "emu/address/abstract_address.h"
+#include "emu/address/page.h"
 #include "emu/bus/bus_word_access_mixin.h"
 #include "emu/utility/dynamic_array.h"
 
+#include <array>
 #include <concepts>
 #include <cstdint>
 #include <ranges>
 #include <stdexcept>
+#include <utility>
 
 namespace emu::bus {
 
@@ -17,6 +20,7 @@ namespace emu::bus {
 class memory_only_bus : public detail::bus_word_access_mixin {
 public:
     static constexpr std::uint32_t memory_size = 0x10000;  // Full 64 KB address space
+    static constexpr std::uint16_t num_pages = memory_size / page_size;
     using memory_array = dynamic_array<std::uint8_t, memory_size>;
 
 public:
@@ -29,30 +33,48 @@ public:
     }
 
     /** Writes a byte to the RAM region; writes to the ROM region are ignored. */
-    void store(abstract_address addr, std::uint8_t value) const noexcept {
-        if (addr.to_uint() < my_ram_size)
+    void store(abstract_address addr, std::uint8_t value) noexcept {
+        if (addr.to_uint() < my_ram_size) {
             my_memory[addr.to_uint()] = value;
+            ++my_page_generations[std::to_underlying(addr.page())];
+        }
+    }
+
+    /** Returns the write generation of a memory page; it changes whenever the page contents may have changed. */
+    page_generation_type page_generation(page_index page_idx) const noexcept {
+        return my_page_generations[std::to_underlying(page_idx)];
     }
 
     /** Copies the provided range of bytes into the RAM region. Throws if the range size exceeds the RAM capacity. */
     template<std::ranges::sized_range Range> requires std::same_as<std::ranges::range_value_t<Range>, std::uint8_t>
-    void set_ram_bytes(Range&& range) const {
+    void set_ram_bytes(Range&& range) {
         if (std::ranges::size(range) > my_ram_size)
             throw std::invalid_argument("memory_only_bus: RAM size exceeds memory capacity");
         std::ranges::copy(range, my_memory.begin());
+        invalidate_all_pages();
     }
 
     /** Copies the provided range of bytes into the ROM region. Throws if the range size exceeds the ROM capacity. */
     template<std::ranges::sized_range Range> requires std::same_as<std::ranges::range_value_t<Range>, std::uint8_t>
-    void set_rom_bytes(Range&& range) const {
+    void set_rom_bytes(Range&& range) {
         if (std::ranges::size(range) + my_ram_size > my_memory.size())
             throw std::invalid_argument("memory_only_bus: ROM size exceeds memory capacity");
         std::ranges::copy(range, my_memory.begin() + my_ram_size);
+        invalidate_all_pages();
+    }
+
+private:
+    /** Advances write generations of all pages. */
+    void invalidate_all_pages() noexcept {
+        for (page_generation_type& generation : my_page_generations)
+            ++generation;
     }
 
 private:
     memory_array& my_memory;
     std::uint32_t my_ram_size;
+
+    std::array<page_generation_type, num_pages> my_page_generations = {};  // Per-page write generations
 };
 
 } // namespace emu::bus
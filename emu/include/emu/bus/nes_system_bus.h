@@ -5,11 +5,14 @@
 #include "emu/apu/vapu.h"
 #include "emu/bus/bus_word_access_mixin.h"
 #include "emu/bus/random_access_memory.h"
+#include "emu/constants.h"
 #include "emu/mapper/concepts.h"
 #include "emu/utility/bit_ops.h"
 
+#include <array>
 #include <cassert>
 #include <cstdint>
+#include <utility>
 
 namespace emu::bus {
 
@@ -21,36 +24,54 @@ class nes_system_bus : public detail::bus_word_access_mixin {
 public:
     nes_system_bus(random_access_memory& ram, Mapper& mapper, PictureInit& ppu, AudioUnit& apu) :
         my_ram(ram), my_mapper(mapper), my_ppu(ppu), my_apu(apu)
-    {}
+    {
+        for (std::uint16_t page = 0; page < std::to_underlying(ram_end.page()); ++page)
+            my_load_pages[page] = my_store_pages[page] = my_ram.page_data(page_index(page));
+
+        publish_prg_pages();
+    }
 
     /** Reads a byte from memory or a device register. */
     std::uint8_t load(abstract_address addr) {
-        if (addr < ram_end)
-            my_open_bus = my_ram.load(addr);
-        else if (addr < ppu_end)
-            my_open_bus = my_ppu.load(addr);
-        else if (addr < apu_end)
-            my_open_bus = my_apu.load(addr);
-        else if (addr >= prg_ram_start)
-            my_open_bus = my_mapper.load_prg(addr);
-
-        return my_open_bus;
+        if (std::uint8_t const* const page = my_load_pages[std::to_underlying(addr.page())]) [[likely]]
+            return my_open_bus = page[get_lo_byte(addr.to_uint())];
+        else
+            return load_io(addr);
     }
 
     /** Writes a byte to memory or a device register. */
     void store(abstract_address addr, std::uint8_t value) {
         my_open_bus = value;
 
-        if (addr < ram_end)
-            my_ram.store(addr, value);
+        if (std::uint8_t* const page = my_store_pages[std::to_underlying(addr.page())]) [[likely]]
+            page[get_lo_byte(addr.to_uint())] = value;
+        else
+            store_io(addr, value);
+
+        advance_generation(addr);
+    }
+
+    /**
+     * Returns the write generation of a memory page; it changes whenever the bytes visible through the page may
+     * have changed. RAM mirrors share generations; any mapper register write (a potential PRG bank switch)
+     * advances the generation of the whole PRG ROM range. Reads from I/O pages have side effects, so any
+     * I/O access advances the shared I/O generation.
+     */
+    page_generation_type page_generation(page_index page_idx) const noexcept {
+        return my_generations[generation_slots[std::to_underlying(page_idx)]];
+    }
+
+    /**
+     * Returns true if reading the address has no side effects and the value read can only change through a CPU write
+     * or at the next PPU frame event (see cpu_cycles_until_frame_event() of the PPU).
+     */
+    bool is_stable_load(abstract_address addr) const noexcept {
+        if (addr < ram_end || addr >= prg_ram_start)
+            return true;
         else if (addr < ppu_end)
-            my_ppu.store(addr, value);
-        else if (addr == oam_dma_register)
-            store_oam_dma(value);
-        else if (addr < apu_end)
-            my_apu.store(addr, value);
-        else if (addr >= prg_ram_start)
-            my_mapper.store_prg(addr, value);
+            return PictureInit::is_status_register_address(addr) && my_ppu.is_status_settled();
+        else
+            return false;
     }
 
 private:
@@ -59,16 +80,89 @@ private:
     static constexpr abstract_address apu_end   = abstract_address{0x4020};
     static constexpr auto oam_dma_register = abstract_address{0x4014};  // Write only
 
+    static constexpr std::uint16_t num_pages = 0x0100;
+    using generation_slot_table = std::array<std::uint8_t, num_pages>;
+
+    /** Maps each page to the page whose generation counter it shares. */
+    static constexpr generation_slot_table make_generation_slots() noexcept {
+        generation_slot_table slots;
+        for (std::uint16_t page = 0; page < num_pages; ++page) {
+            abstract_address const addr{page_index(page)};
+            if (addr < ram_end)
+                slots[page] = page % (random_access_memory::ram_size / page_size);
+            else if (addr < prg_ram_start)
+                slots[page] = std::to_underlying(ram_end.page());  // Shared I/O slot
+            else if (addr < prg_rom_start)
+                slots[page] = page;
+            else
+                slots[page] = std::to_underlying(prg_rom_start.page());  // Shared PRG ROM slot
+        }
+
+        return slots;
+    }
+
+    static constexpr auto generation_slots = make_generation_slots();
+
     ///////////////////////////////////////////////////////////////////////////
 
 private:
-    void store_oam_dma(std::uint8_t value) const noexcept {
+    /** Reads a byte from a page that is not mapped directly to memory. */
+    std::uint8_t load_io(abstract_address addr) {
+        if (addr < ppu_end) {
+            my_open_bus = my_ppu.load(addr);
+            advance_generation(addr);
+        }
+        else if (addr < apu_end) {
+            my_open_bus = my_apu.load(addr);
+            advance_generation(addr);
+        }
+        else if (addr >= prg_ram_start)
+            my_open_bus = my_mapper.load_prg(addr);
+
+        return my_open_bus;
+    }
+
+    /** Writes a byte to a page that is not mapped directly to memory. */
+    void store_io(abstract_address addr, std::uint8_t value) {
+        if (addr < ppu_end)
+            my_ppu.store(addr, value);
+        else if (addr == oam_dma_register)
+            store_oam_dma(value);
+        else if (addr < apu_end)
+            my_apu.store(addr, value);
+        else if (addr >= prg_ram_start) {
+            my_ppu.catch_up();  // The write may switch CHR banks or mirroring
+            my_apu.catch_up();  // The write may switch the PRG banks DMC samples are fetched from
+            my_mapper.store_prg(addr, value);
+            publish_prg_pages();  // The write may have switched banks
+        }
+    }
+
+    /** Updates the directly mapped pages of the PRG RAM/ROM range from the mapper. */
+    void publish_prg_pages() noexcept {
+        for (std::uint16_t page = std::to_underlying(prg_ram_start.page()); page < num_pages; ++page) {
+            my_load_pages[page] = my_mapper.prg_load_page(page_index(page));
+            my_store_pages[page] = my_mapper.prg_store_page(page_index(page));
+        }
+    }
+
+    void store_oam_dma(std::uint8_t value) const {
+        my_ppu.catch_up();
         my_ppu.store_oam_data_dma(my_ram.page(page_index{value}));
     }
 
+    void advance_generation(abstract_address addr) noexcept {
+        ++my_generations[generation_slots[std::to_underlying(addr.page())]];
+    }
+
 private:
     std::uint8_t my_open_bus = std::uint8_t{0x00};  // Open bus: The last value read from a register or written to a register
 
+    std::array<page_generation_type, num_pages> my_generations = {};  // Write generations indexed by generation slots
+
+    std::array<std::uint8_t const*, num_pages> my_load_pages  = {};  // Directly readable pages, nullptr for I/O pages
+    std::array<std::uint8_t*,       num_pages> my_store_pages = {};  // Directly writable pages, nullptr for I/O pages
+
     random_access_memory& my_ram;
 
     Mapper&      my_mapper;
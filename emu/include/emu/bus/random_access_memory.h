@@ -29,6 +29,9 @@ public:
     /** Returns a 256-byte span representing one RAM page. */
     page_span page(page_index) const noexcept;
 
+    /** Returns a pointer to the first byte of one (mirrored) RAM page. */
+    std::uint8_t* page_data(page_index) noexcept;
+
 private:
     /** Returns a mirrored address in the canonical RAM range $0000-$07FF. */
     static abstract_address mirrored_address(abstract_address) noexcept;
@@ -21,6 +21,7 @@ namespace addressing_mode_tags {
 #define EMU_DEFINE_ADDRESSING_MODE_TAG(AddressingModeTag, Operand)              \
     struct AddressingModeTag : detail::addressing_mode_tag_base {               \
         using operand = Operand;                                                \
+        static constexpr char const* name = #AddressingModeTag;                 \
     }
 
 EMU_DEFINE_ADDRESSING_MODE_TAG(imm,   byte_operand);  // immediate
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "emu/address/absolute_address.h"
+#include "emu/address/page.h"
+#include "emu/cpu/opcode_decoder.h"
+#include "emu/utility/bit_ops.h"
+#include "emu/utility/dynamic_array.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace emu::cpu {
+
+/**
+ * Cache of predecoded instructions indexed by PC. An entry remembers the write generation of its memory
+ * page (see page_generation() of the bus) and is decoded again once RAM writes or PRG bank switches
+ * change that generation. Instructions whose operand crosses a page boundary are never cached.
+ *
+ * With EMU_SUPERINSTRUCTIONS, an entry holds a superinstruction if the instruction and the one that follows it
+ * in the same page form a pair listed in superinstruction_pairs.
+ */
+template<class Cpu>
+class decoded_instruction_cache {
+public:
+    decoded_instruction_cache() {
+        std::ranges::fill(my_entries, entry{.instr = {}, .generation = invalid_generation});
+    }
+
+    /** Returns the decoded instruction at the given address, decoding it on a cache miss. */
+    decoded_instruction<Cpu> fetch(auto& bus, absolute_address pc) {
+        if (!is_cacheable(pc)) [[unlikely]]
+            return opcode_decoder<Cpu>::decode(bus, pc);
+
+        entry& cached = my_entries[pc.to_uint()];
+
+        page_generation_type const generation = bus.page_generation(pc.page());
+        if (cached.generation != generation) [[unlikely]] {
+            cached.instr = opcode_decoder<Cpu>::decode(bus, pc);
+            cached.generation = generation;
+
+#ifdef EMU_SUPERINSTRUCTIONS
+            fuse_with_next(bus, pc, cached.instr);
+#endif
+        }
+
+        return cached.instr;
+    }
+
+private:
+    struct entry {
+        decoded_instruction<Cpu> instr;
+        page_generation_type generation;
+    };
+
+    static constexpr std::uint32_t num_entries = 0x10000;  // One entry per address of the 64 KB address space
+    static constexpr page_generation_type invalid_generation = ~page_generation_type{0};
+
+    /** Returns true if the longest (3-byte) instruction at the given address fits in a single page. */
+    static bool is_cacheable(absolute_address pc) noexcept {
+        return get_lo_byte(pc.to_uint()) <= 0xFD;
+    }
+
+#ifdef EMU_SUPERINSTRUCTIONS
+    /**
+     * Fuses a decoded instruction with the next one into a superinstruction if possible. Instructions in the zero
+     * page or one of its RAM mirrors are never fused, as a zero page store of the first instruction could modify
+     * the second one.
+     */
+    static void fuse_with_next(auto& bus, absolute_address pc, decoded_instruction<Cpu>& instr) {
+        absolute_address const next_pc = pc + instr.size;
+        if (is_zero_page_mirror(pc.page()) || next_pc.page() != pc.page() || !is_cacheable(next_pc))
+            return;
+
+        opcode_decoder<Cpu>::fuse(instr, opcode_decoder<Cpu>::decode(bus, next_pc));
+    }
+
+    /** Returns true if a page is the zero page or one of its mirrors ($08, $10, $18). */
+    static constexpr bool is_zero_page_mirror(page_index page) noexcept {
+        return std::to_underlying(page) < 0x20 && (std::to_underlying(page) & 0x07) == 0;
+    }
+#endif
+
+private:
+    dynamic_array<entry, num_entries> my_entries;
+};
+
+} // namespace emu::cpu
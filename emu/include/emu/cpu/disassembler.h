@@ -1,15 +1,38 @@
 #pragma once
 
 #include "operand.h"
+#include "emu/address/absolute_address.h"
 #include "emu/cpu/addressing_mode_tags.h"
+#include "emu/cpu/instruction_tags.h"
 #include "emu/utility/bit_ops.h"
 
 #include <cstdint>
 #include <format>
 #include <string>
 
+namespace emu::cpu {
+
+/** Disassembled instruction. */
+struct disasm_info {
+    absolute_address pc;
+    std::string instr_name;
+    std::string addr_mode;
+    std::string bytes;
+    std::string operand;
+};
+
+} // namespace emu::cpu
+
 namespace emu::cpu::detail {
 
+template<instruction_type InstType>
+std::string to_instr_name(char const* name) {
+    if constexpr (InstType == instruction_type::official)
+        return " " + std::string(name);
+    else
+        return "*" + std::string(name);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 template<addressing_mode_tag AddrMode, class Operand = AddrMode::operand>
@@ -90,4 +113,79 @@ inline std::string to_asm_string(addressing_mode_tags::ind, absolute_address /*
     return std::format("(${:04X}) = {:04X}", *op, op_access.get().to_uint());
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/** Operand formatting without memory access (e.g., for offline disassembly of recorded traces). */
+
+inline std::string to_asm_string(addressing_mode_tags::imm, absolute_address /* pc */, byte_operand op) {
+    return std::format("#${:02X}", *op);
+}
+
+inline std::string to_asm_string(addressing_mode_tags::imp, absolute_address /* pc */, null_operand) {
+    return {};
+}
+
+inline std::string to_asm_string(addressing_mode_tags::acc, absolute_address /* pc */, null_operand) {
+    return "A";
+}
+
+inline std::string to_asm_string(addressing_mode_tags::rel, absolute_address pc, byte_operand op) {
+    std::uint16_t const addr = pc.to_uint() + static_cast<std::int8_t>(*op + 2);
+    return std::format("${:04X}", addr);
+}
+
+inline std::string to_asm_string(addressing_mode_tags::abs, absolute_address /* pc */, word_operand op) {
+    return std::format("${:04X}", *op);
+}
+
+inline std::string to_asm_string(addressing_mode_tags::abs_x, absolute_address /* pc */, word_operand op) {
+    return std::format("${:04X},X", *op);
+}
+
+inline std::string to_asm_string(addressing_mode_tags::abs_y, absolute_address /* pc */, word_operand op) {
+    return std::format("${:04X},Y", *op);
+}
+
+inline std::string to_asm_string(addressing_mode_tags::x_ind, absolute_address /* pc */, byte_operand op) {
+    return std::format("(${:02X},X)", *op);
+}
+
+inline std::string to_asm_string(addressing_mode_tags::ind_y, absolute_address /* pc */, byte_operand op) {
+    return std::format("(${:02X}),Y", *op);
+}
+
+inline std::string to_asm_string(addressing_mode_tags::zpg, absolute_address /* pc */, byte_operand op) {
+    return std::format("${:02X}", *op);
+}
+
+inline std::string to_asm_string(addressing_mode_tags::zpg_x, absolute_address /* pc */, byte_operand op) {
+    return std::format("${:02X},X", *op);
+}
+
+inline std::string to_asm_string(addressing_mode_tags::zpg_y, absolute_address /* pc */, byte_operand op) {
+    return std::format("${:02X},Y", *op);
+}
+
+inline std::string to_asm_string(addressing_mode_tags::ind, absolute_address /* pc */, word_operand op) {
+    return std::format("(${:04X})", *op);
+}
+
+/** Disassembles an instruction from its raw bytes. */
+template<instruction_tag InstTag, addressing_mode_tag AddrModeTag, instruction_type InstType>
+disasm_info disassemble(std::uint8_t opcode, absolute_address pc, std::uint16_t raw_operand) {
+    typename AddrModeTag::operand const op(raw_operand);
+
+    return {
+        .pc = pc,
+        .instr_name = to_instr_name<InstType>(InstTag::name),
+        .addr_mode = AddrModeTag::name,
+        .bytes = to_bytes_string<AddrModeTag>(opcode, op),
+        .operand = to_asm_string(AddrModeTag{}, pc, op)
+    };
+}
+
+/** Disassembles an illegal (unimplemented) instruction. */
+inline disasm_info disassemble_illegal(std::uint8_t opcode, absolute_address pc, std::uint16_t /* raw_operand */) {
+    return {.pc = pc, .instr_name = " ???", .addr_mode = {}, .bytes = std::format("{:02X}", opcode), .operand = {}};
+}
+
 } // namespace emu::cpu::detail
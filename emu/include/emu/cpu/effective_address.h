@@ -1,7 +1,6 @@
 #pragma once
 
 #include "emu/cpu/addressing_mode_tags.h"
-#include "emu/cpu/vcpu.h"
 #include "emu/cpu/vcpu_state.h"
 #include "emu/utility/functional.h"
 
@@ -21,8 +20,8 @@ namespace detail {
 /** Effective address calculator for absolute addressing modes. */
 template<auto OffsetFn, bool AddCycleOnPageCross = false>
 struct effective_address_abs {
-    template<class Bus>
-    static absolute_address get(vcpu<Bus>& cpu, word_operand op) {
+    template<class Cpu>
+    static absolute_address get(Cpu& cpu, word_operand op) {
         absolute_address const abs_addr = absolute_address{*op};
         absolute_address const eff_addr = abs_addr + std::invoke(OffsetFn, cpu);
 
@@ -37,8 +36,8 @@ struct effective_address_abs {
 /** Effective address calculator for indirect addressing modes. */
 template<auto PreOffsetFn, auto PostOffsetFn, bool AddCycleOnPageCross = false>
 struct effective_address_ind {
-    template<class Bus, class Operand>
-    static absolute_address get(vcpu<Bus>& cpu, Operand op) {
+    template<class Cpu, class Operand>
+    static absolute_address get(Cpu& cpu, Operand op) {
         same_page_address const addr = same_page_address{*op} + std::invoke(PreOffsetFn, cpu);
 
         absolute_address const abs_addr = absolute_address{cpu.system_bus().load_word(addr)};
@@ -55,8 +54,8 @@ struct effective_address_ind {
 /** Effective address calculator for zero page addressing modes. */
 template<auto OffsetFn>
 struct effective_address_zpg {
-    template<class Bus>
-    static zp_address get(vcpu<Bus> const& cpu, byte_operand op) {
+    template<class Cpu>
+    static zp_address get(Cpu const& cpu, byte_operand op) {
         zp_address const zp_addr = zp_address{*op};
         return zp_addr + std::invoke(OffsetFn, cpu);
     }
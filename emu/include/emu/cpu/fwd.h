@@ -7,6 +7,8 @@ class byte_operand;
 class word_operand;
 
 class vcpu_state;
-template<class Bus> class vcpu;
+
+struct no_trace;
+template<class Bus, class TracePolicy = no_trace> class vcpu;
 
 } // namespace emu::cpu
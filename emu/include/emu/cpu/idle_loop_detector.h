@@ -0,0 +1,120 @@
+#pragma once
+
+#include "emu/address/absolute_address.h"
+#include "emu/cpu/opcode_decoder.h"
+#include "emu/cpu/operand.h"
+#include "emu/cpu/vcpu_state.h"
+
+#include <cstdint>
+#include <utility>
+
+namespace emu::cpu {
+
+/**
+ * Detects idle loops: short loops, such as "JMP *" or "LDA $2002 / BPL", that only read memory the bus reports as
+ * stable (see is_stable_load() of the bus) and that reach their first instruction with the same register values
+ * on every iteration. Such a loop repeats identically until an external event (an NMI or a PPU status change),
+ * so the caller may skip its iterations up to that event.
+ */
+template<class Cpu>
+class idle_loop_detector {
+public:
+    using cycle_counter_type = vcpu_state::cycle_counter_type;
+
+    /** Maximum distance between the first and the last instruction of a loop, in bytes. */
+    static constexpr std::uint16_t max_loop_size = 16;
+
+    /**
+     * Observes a CPU right after it executed the instruction at old_pc. Returns the length of a single loop
+     * iteration in cycles if the CPU spins in an idle loop and no NMI is pending, or zero otherwise. If the
+     * instruction was a superinstruction, the loop body ends with its first instruction; the second one can
+     * only be a branch or an absolute jump, which accesses no memory (see opcode_decoder::is_fusable_pair()).
+     */
+    cycle_counter_type observe(Cpu& cpu, absolute_address old_pc) {
+        absolute_address const pc = cpu.pc();
+        if (pc > old_pc || old_pc.to_uint() - pc.to_uint() >= max_loop_size) [[likely]]
+            return 0;  // Not a short backward jump
+
+        if (cpu.is_nmi_pending())
+            return 0;
+
+        loop_head const head{
+            .pc = pc, .a = cpu.a(), .x = cpu.x(), .y = cpu.y(), .sp = cpu.sp(), .flags = cpu.flags().to_uint()
+        };
+
+        cycle_counter_type const cycles = cpu.cycle_counter();
+        cycle_counter_type const iteration_cycles = cycles - my_last_cycles;
+        my_last_cycles = cycles;
+
+        if (head != my_last_head) {
+            my_last_head = head;
+            my_last_iteration_cycles = 0;
+            return 0;
+        }
+
+        // Two equal iterations in a row rule out an interrupt handler that ran in between
+        if (iteration_cycles != std::exchange(my_last_iteration_cycles, iteration_cycles))
+            return 0;
+
+        return is_idle_loop_body(cpu.system_bus(), pc, old_pc) ? iteration_cycles : 0;
+    }
+
+private:
+    /** CPU registers at the first instruction of a loop. */
+    struct loop_head {
+        absolute_address pc;
+        std::uint8_t a;
+        std::uint8_t x;
+        std::uint8_t y;
+        std::uint8_t sp;
+        std::uint8_t flags;
+
+        bool operator==(loop_head const&) const = default;
+    };
+
+    /** Returns true if instructions in [first_pc, last_pc] have no side effects and read only stable memory. */
+    static bool is_idle_loop_body(auto& bus, absolute_address first_pc, absolute_address last_pc) {
+        absolute_address pc = first_pc;
+        while (pc <= last_pc) {
+            std::uint8_t const opcode = bus.load(pc);
+
+            switch (opcode_decoder<Cpu>::memory_effect_of(opcode)) {
+            case memory_effect::none:
+                break;
+
+            case memory_effect::direct_load:
+                if (!bus.is_stable_load(operand_address(bus, pc, opcode)))
+                    return false;
+                break;
+
+            case memory_effect::indexed_load:
+            case memory_effect::zero_page_store:
+            case memory_effect::other:
+                return false;
+            }
+
+            if (pc == last_pc)
+                return true;
+
+            pc = pc + opcode_decoder<Cpu>::instruction_size(opcode);
+        }
+
+        return false;  // The last instruction is not aligned with the decoded ones
+    }
+
+    /** Returns the operand address of a zero page or absolute instruction. */
+    static absolute_address operand_address(auto& bus, absolute_address pc, std::uint8_t opcode) {
+        if (opcode_decoder<Cpu>::instruction_size(opcode) == 1 + word_operand::size)
+            return absolute_address{bus.load_word(pc + 1)};
+        else
+            return absolute_address{bus.load(pc + 1)};
+    }
+
+private:
+    loop_head my_last_head = {};
+
+    cycle_counter_type my_last_cycles = 0;
+    cycle_counter_type my_last_iteration_cycles = 0;
+};
+
+} // namespace emu::cpu
@@ -1,11 +1,16 @@
 #pragma once
 
+#include "emu/utility/type_traits.h"
+
 #include <concepts>
 
 namespace emu::cpu {
 
 namespace cpu_detail { struct instruction_tag_base {}; }
 
+/** Official or unofficial (undocumented) instruction. */
+enum class instruction_type { official, unofficial };
+
 /** CPU instruction tag type. */
 template<class InstructionTag>
 concept instruction_tag =
@@ -111,4 +116,27 @@ EMU_DEFINE_INSTRUCTION_TAG(NOP);  // no operation
 
 } // namespace instruction_tags
 
+/** This concept is satisfied by instructions that may transfer control to a non-sequential address. */
+template<class InstructionTag>
+concept control_transfer_instruction_tag = instruction_tag<InstructionTag> && same_as_any_of<InstructionTag,
+    instruction_tags::JMP, instruction_tags::JSR, instruction_tags::RTS,
+    instruction_tags::BCC, instruction_tags::BCS, instruction_tags::BNE, instruction_tags::BEQ,
+    instruction_tags::BPL, instruction_tags::BMI, instruction_tags::BVC, instruction_tags::BVS,
+    instruction_tags::BRK, instruction_tags::RTI>;
+
+/** This concept is satisfied by instructions that can modify only registers, flags and PC (memory is only read). */
+template<class InstructionTag>
+concept register_only_instruction_tag = instruction_tag<InstructionTag> && same_as_any_of<InstructionTag,
+    instruction_tags::LDA, instruction_tags::LDX, instruction_tags::LDY, instruction_tags::LAX,
+    instruction_tags::TAX, instruction_tags::TAY, instruction_tags::TXA, instruction_tags::TYA,
+    instruction_tags::TSX, instruction_tags::TXS,
+    instruction_tags::ADC, instruction_tags::SBC, instruction_tags::CMP, instruction_tags::CPX, instruction_tags::CPY,
+    instruction_tags::INX, instruction_tags::DEX, instruction_tags::INY, instruction_tags::DEY,
+    instruction_tags::AND, instruction_tags::EOR, instruction_tags::ORA, instruction_tags::BIT,
+    instruction_tags::ANC, instruction_tags::ALR, instruction_tags::JMP,
+    instruction_tags::BCC, instruction_tags::BCS, instruction_tags::BNE, instruction_tags::BEQ,
+    instruction_tags::BPL, instruction_tags::BMI, instruction_tags::BVC, instruction_tags::BVS,
+    instruction_tags::CLC, instruction_tags::CLD, instruction_tags::CLI, instruction_tags::CLV,
+    instruction_tags::SEC, instruction_tags::SED, instruction_tags::SEI, instruction_tags::NOP>;
+
 } // namespace emu::cpu
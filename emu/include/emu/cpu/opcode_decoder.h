@@ -1,59 +1,319 @@
 #pragma once
 
 #include "emu/cpu/addressing_mode_tags.h"
+#include "emu/cpu/disassembler.h"
 #include "emu/cpu/exceptions.h"
 #include "emu/cpu/fwd.h"
 #include "emu/cpu/instruction_tags.h"
 #include "emu/cpu/num_cycles.h"
 #include "emu/cpu/operand_access.h"
+#include "emu/cpu/superinstructions.h"
+#include "emu/cpu/vcpu_state.h"
+#include "emu/utility/type_traits.h"
 
 #include <array>
 #include <cstdint>
 #include <functional>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Threaded dispatch (enabled by EMU_THREADED_DISPATCH): each instruction handler fetches the next instruction
+ * and tail-calls its handler directly. Guaranteed tail calls are required to keep the stack depth bounded.
+ */
+#ifdef EMU_THREADED_DISPATCH
+    #if __has_cpp_attribute(clang::musttail)
+        #define EMU_MUSTTAIL [[clang::musttail]]
+    #elif __has_cpp_attribute(gnu::musttail)
+        #define EMU_MUSTTAIL [[gnu::musttail]]
+    #else
+        #error "EMU_THREADED_DISPATCH requires [[clang::musttail]] or [[gnu::musttail]] support"
+    #endif
+#endif
 
 namespace emu::cpu {
 
-enum class instruction_type { official, unofficial };
+/** Memory access performed by an instruction in addition to its opcode and operand fetch. */
+enum class memory_effect : std::uint8_t {
+    none,             // Modifies only registers, flags and PC
+    direct_load,      // As above, but also loads from the (zero page or absolute) operand address
+    indexed_load,     // As above, but loads from an indexed or indirect operand address
+    zero_page_store,  // Loads and stores only within the zero page
+    other             // Stack accesses and stores outside the zero page
+};
+
+/** Instruction with its opcode and operand bytes already fetched from memory. */
+template<class Cpu>
+struct decoded_instruction {
+    using handler_fn_ptr = void(*)(Cpu&, std::uint8_t /* opcode */, std::uint32_t /* raw operand */);
+
+    handler_fn_ptr handler;
+    std::uint32_t  operand;  // Raw operand bytes, little-endian (a superinstruction packs the bytes of both operands)
+    std::uint8_t   opcode;   // Opcode of the (first) instruction
+    std::uint8_t   size;     // Size in bytes, including opcodes
+};
 
-template<class Bus>
+template<class Cpu>
 struct opcode_decoder {
 private:
-    using cpu_type = vcpu<Bus>;
-    using instruction_fn_ptr = void(*)(cpu_type&, std::uint8_t /*opcode */);
-    using opcode_table = std::array<instruction_fn_ptr, 256>;
+    using cpu_type = Cpu;
+    using bus_type = typename Cpu::bus_type;
+    using cycle_counter_type = vcpu_state::cycle_counter_type;
+
+    using instruction_fn_ptr = decoded_instruction<Cpu>::handler_fn_ptr;
+    using threaded_fn_ptr = void(*)(cpu_type&, decoded_instruction<Cpu>, cycle_counter_type /* end_cycle */);
+    using disasm_fn_ptr = disasm_info(*)(std::uint8_t /* opcode */, absolute_address /* pc */, std::uint16_t /* raw operand */);
+
+    /** Opcode table entry. */
+    struct opcode_info {
+        instruction_fn_ptr handler;
+        std::uint8_t operand_size;
+        bool transfers_control;  // Control transfer or illegal instruction
+        memory_effect mem_effect;
+        disasm_fn_ptr disassemble;
+#ifdef EMU_THREADED_DISPATCH
+        threaded_fn_ptr threaded_handler;
+#endif
+    };
+
+    using opcode_table = std::array<opcode_info, 256>;
 
 public:
-    static void execute(cpu_type& cpu, std::uint8_t opcode);
+    /** Fetches an opcode and its operand bytes from the given address. */
+    static decoded_instruction<Cpu> decode(bus_type& bus, absolute_address pc);
+
+    /** Returns the size of an instruction in bytes, including its opcode. */
+    static constexpr std::uint8_t instruction_size(std::uint8_t opcode) noexcept {
+        return 1 + my_opcode_table[opcode].operand_size;
+    }
+
+    /** Returns the memory access an instruction performs. */
+    static constexpr memory_effect memory_effect_of(std::uint8_t opcode) noexcept {
+        return my_opcode_table[opcode].mem_effect;
+    }
+
+    /** Disassembles an instruction from its raw bytes without accessing memory. */
+    static disasm_info disassemble(std::uint8_t opcode, absolute_address pc, std::uint16_t raw_operand) {
+        return my_opcode_table[opcode].disassemble(opcode, pc, raw_operand);
+    }
+
+    /** Executes a previously decoded instruction. */
+    static void execute(cpu_type& cpu, decoded_instruction<Cpu> const& instr);
+
+    /**
+     * Returns true if two instructions can be executed as one. The first instruction must fall through to the
+     * second one and must not store outside the zero page, so no write to a code page can occur between them.
+     * The second instruction may transfer control only by a branch or an absolute jump, which access no memory.
+     * An NMI raised between them (by a PPU register read) stops the superinstruction after the first one.
+     */
+    static constexpr bool is_fusable_pair(std::uint8_t first_opcode, std::uint8_t second_opcode) noexcept;
+
+    /** Returns true if a decoded instruction is a superinstruction (see fuse()). */
+    static constexpr bool is_superinstruction(decoded_instruction<Cpu> const& instr) noexcept {
+        return instr.size != instruction_size(instr.opcode);
+    }
+
+#ifdef EMU_SUPERINSTRUCTIONS
+    /**
+     * Replaces the first of two consecutive decoded instructions with a superinstruction that executes both of
+     * them if the pair is listed in superinstruction_pairs. Returns true if the instructions were fused.
+     */
+    static bool fuse(decoded_instruction<Cpu>& first, decoded_instruction<Cpu> const& second) noexcept;
+#endif
+
+#ifdef EMU_THREADED_DISPATCH
+    /**
+     * Executes instructions without returning to the caller between them until an NMI becomes pending
+     * or the cycle counter reaches end_cycle. Throws infinite_loop on a single-instruction loop.
+     */
+    static void run_threaded(cpu_type& cpu, cycle_counter_type end_cycle);
+#endif
 
 private:
     template<instruction_tag, addressing_mode_tag, num_cycles NumCycles, instruction_type>
-    static void execute(cpu_type&, std::uint8_t opcode);
+    static void execute(cpu_type&, std::uint8_t opcode, std::uint32_t raw_operand);
+
+    static void execute_illegal(cpu_type&, std::uint8_t opcode, std::uint32_t raw_operand);
+
+#ifdef EMU_THREADED_DISPATCH
+    template<instruction_fn_ptr Handler>
+    static void execute_threaded(cpu_type&, decoded_instruction<Cpu>, cycle_counter_type end_cycle);
+#endif
 
-    static void op_illegal(cpu_type&, std::uint8_t opcode);
+    template<instruction_tag InstTag, addressing_mode_tag AddrModeTag>
+    static constexpr memory_effect get_memory_effect() noexcept;
+
+    template<instruction_fn_ptr Handler, std::uint8_t OperandSize, bool TransfersControl, memory_effect MemEffect, disasm_fn_ptr DisasmFn>
+    static constexpr opcode_info make_opcode_info = {
+        .handler           = Handler,
+        .operand_size      = OperandSize,
+        .transfers_control = TransfersControl,
+        .mem_effect        = MemEffect,
+        .disassemble       = DisasmFn,
+#ifdef EMU_THREADED_DISPATCH
+        .threaded_handler  = &execute_threaded<Handler>
+#endif
+    };
 
     /** Official instructions */
     template<instruction_tag InstTag, addressing_mode_tag AddrModeTag, num_cycles NumCycles>
-    static constexpr auto op = &execute<InstTag, AddrModeTag, NumCycles, instruction_type::official>;
+    static constexpr auto op = make_opcode_info<&execute<InstTag, AddrModeTag, NumCycles, instruction_type::official>,
+        AddrModeTag::operand::size, control_transfer_instruction_tag<InstTag>, get_memory_effect<InstTag, AddrModeTag>(),
+        &detail::disassemble<InstTag, AddrModeTag, instruction_type::official>>;
 
     /** Unofficial instructions */
     template<instruction_tag InstTag, addressing_mode_tag AddrModeTag, num_cycles NumCycles>
-    static constexpr auto up = &execute<InstTag, AddrModeTag, NumCycles, instruction_type::unofficial>;
+    static constexpr auto up = make_opcode_info<&execute<InstTag, AddrModeTag, NumCycles, instruction_type::unofficial>,
+        AddrModeTag::operand::size, control_transfer_instruction_tag<InstTag>, get_memory_effect<InstTag, AddrModeTag>(),
+        &detail::disassemble<InstTag, AddrModeTag, instruction_type::unofficial>>;
+
+    /** Illegal (unimplemented) instructions */
+    static constexpr auto op_illegal = make_opcode_info<&execute_illegal, 0, true, memory_effect::other, &detail::disassemble_illegal>;
 
     static constexpr opcode_table make_opcode_table() noexcept;
 
+#ifdef EMU_SUPERINSTRUCTIONS
+    /** Superinstruction table entry. */
+    struct fused_info {
+        std::uint8_t first_opcode;
+        std::uint8_t second_opcode;
+        instruction_fn_ptr handler;
+    };
+
+    template<std::uint8_t FirstOpcode, std::uint8_t SecondOpcode>
+    static void execute_fused(cpu_type&, std::uint8_t opcode, std::uint32_t raw_operand);
+
+    static constexpr auto make_fused_table() noexcept;
+#endif
+
 private:
     static constexpr auto my_opcode_table = make_opcode_table();
+
+#ifdef EMU_SUPERINSTRUCTIONS
+    static constexpr auto my_fused_table = make_fused_table();
+#endif
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-template<class Bus>
-void opcode_decoder<Bus>::execute(cpu_type& cpu, std::uint8_t opcode) {
-    std::invoke(my_opcode_table[opcode], cpu, opcode);
+template<class Cpu>
+decoded_instruction<Cpu> opcode_decoder<Cpu>::decode(bus_type& bus, absolute_address pc) {
+    std::uint8_t const opcode = bus.load(pc);
+    opcode_info const& info = my_opcode_table[opcode];
+
+    std::uint16_t raw_operand = 0;
+    if (info.operand_size == byte_operand::size)
+        raw_operand = bus.load(pc + 1);
+    else if (info.operand_size == word_operand::size)
+        raw_operand = bus.load_word(pc + 1);
+
+    return {.handler = info.handler, .operand = raw_operand, .opcode = opcode, .size = instruction_size(opcode)};
+}
+
+template<class Cpu>
+void opcode_decoder<Cpu>::execute(cpu_type& cpu, decoded_instruction<Cpu> const& instr) {
+    std::invoke(instr.handler, cpu, instr.opcode, instr.operand);
+}
+
+template<class Cpu>
+constexpr bool opcode_decoder<Cpu>::is_fusable_pair(std::uint8_t first_opcode, std::uint8_t second_opcode) noexcept {
+    opcode_info const& first = my_opcode_table[first_opcode];
+    opcode_info const& second = my_opcode_table[second_opcode];
+
+    return !first.transfers_control && first.mem_effect != memory_effect::other
+        && !(second.transfers_control && second.mem_effect == memory_effect::other);
+}
+
+#ifdef EMU_SUPERINSTRUCTIONS
+template<class Cpu>
+bool opcode_decoder<Cpu>::fuse(decoded_instruction<Cpu>& first, decoded_instruction<Cpu> const& second) noexcept {
+    for (fused_info const& fused : my_fused_table) {
+        if (fused.first_opcode == first.opcode && fused.second_opcode == second.opcode) {
+            first.handler = fused.handler;
+            first.operand |= second.operand << (8 * my_opcode_table[first.opcode].operand_size);
+            first.size += second.size;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+template<class Cpu>
+template<std::uint8_t FirstOpcode, std::uint8_t SecondOpcode>
+void opcode_decoder<Cpu>::execute_fused(cpu_type& cpu, std::uint8_t /* opcode */, std::uint32_t raw_operand) {
+    static_assert(is_fusable_pair(FirstOpcode, SecondOpcode), "Instruction pair cannot be fused");
+
+    constexpr instruction_fn_ptr first_handler = my_opcode_table[FirstOpcode].handler;
+    constexpr instruction_fn_ptr second_handler = my_opcode_table[SecondOpcode].handler;
+    constexpr unsigned first_operand_bits = 8 * my_opcode_table[FirstOpcode].operand_size;
+
+    // Each handler advances PC and the cycle counter on its own, so the pair takes exactly as long as the two
+    // instructions executed one by one
+    first_handler(cpu, FirstOpcode, raw_operand & ~(~std::uint32_t{0} << first_operand_bits));
+
+    // The NMI is taken before the second instruction; the caller sees PC stop short of the end of the pair
+    if (cpu.is_nmi_pending()) [[unlikely]]
+        return;
+
+    second_handler(cpu, SecondOpcode, raw_operand >> first_operand_bits);
+}
+
+template<class Cpu>
+constexpr auto opcode_decoder<Cpu>::make_fused_table() noexcept {
+    return []<std::size_t... Index>(std::index_sequence<Index...>) {
+        return std::array{fused_info{
+            .first_opcode  = superinstruction_pairs[Index].first,
+            .second_opcode = superinstruction_pairs[Index].second,
+            .handler       = &execute_fused<superinstruction_pairs[Index].first, superinstruction_pairs[Index].second>
+        }...};
+    }(std::make_index_sequence<superinstruction_pairs.size()>{});
+}
+#endif
+
+#ifdef EMU_THREADED_DISPATCH
+template<class Cpu>
+void opcode_decoder<Cpu>::run_threaded(cpu_type& cpu, cycle_counter_type end_cycle) {
+    decoded_instruction<Cpu> const instr = cpu.fetch_instruction();
+    my_opcode_table[instr.opcode].threaded_handler(cpu, instr, end_cycle);
+}
+
+template<class Cpu>
+template<typename opcode_decoder<Cpu>::instruction_fn_ptr Handler>
+void opcode_decoder<Cpu>::execute_threaded(cpu_type& cpu, decoded_instruction<Cpu> instr, cycle_counter_type end_cycle) {
+    absolute_address const init_pc = cpu.pc();
+    Handler(cpu, instr.opcode, instr.operand);
+
+    if (cpu.pc() == init_pc) [[unlikely]]
+        throw infinite_loop(init_pc);
+
+    if (cpu.is_nmi_pending() || cpu.cycle_counter() >= end_cycle) [[unlikely]]
+        return;
+
+    decoded_instruction<Cpu> const next_instr = cpu.fetch_instruction();
+    EMU_MUSTTAIL return my_opcode_table[next_instr.opcode].threaded_handler(cpu, next_instr, end_cycle);
+}
+#endif
+
+template<class Cpu>
+template<instruction_tag InstTag, addressing_mode_tag AddrModeTag>
+constexpr memory_effect opcode_decoder<Cpu>::get_memory_effect() noexcept {
+    using namespace addressing_mode_tags;
+
+    if constexpr (std::is_same_v<AddrModeTag, acc>)
+        return memory_effect::none;
+    else if constexpr (!register_only_instruction_tag<InstTag>)
+        return same_as_any_of<AddrModeTag, zpg, zpg_x, zpg_y> ? memory_effect::zero_page_store : memory_effect::other;
+    else if constexpr (same_as_any_of<AddrModeTag, imp, imm, rel> || std::is_same_v<InstTag, instruction_tags::JMP>)
+        return std::is_same_v<AddrModeTag, ind> ? memory_effect::other : memory_effect::none;
+    else if constexpr (same_as_any_of<AddrModeTag, zpg, abs>)
+        return memory_effect::direct_load;
+    else
+        return memory_effect::indexed_load;
 }
 
-template<class Bus>
-constexpr auto opcode_decoder<Bus>::make_opcode_table() noexcept -> opcode_table {
+template<class Cpu>
+constexpr auto opcode_decoder<Cpu>::make_opcode_table() noexcept -> opcode_table {
     using namespace addressing_mode_tags;
     using namespace instruction_tags;
     using namespace page_cross_literals;
@@ -80,19 +340,18 @@ constexpr auto opcode_decoder<Bus>::make_opcode_table() noexcept -> opcode_table
     };
 }
 
-template<class Bus>
+template<class Cpu>
 template<instruction_tag InstTag, addressing_mode_tag AddrModeTag, num_cycles NumCycles, instruction_type InstType>
-void opcode_decoder<Bus>::execute(vcpu<Bus>& cpu, std::uint8_t opcode) {
+void opcode_decoder<Cpu>::execute(cpu_type& cpu, std::uint8_t opcode, std::uint32_t raw_operand) {
     absolute_address const init_pc = cpu.pc();
-    //cpu.set_pc(cpu.pc() + 1);  // 1 = opcode size
 
-    typename AddrModeTag::operand const op(init_pc + 1, cpu.system_bus());
+    typename AddrModeTag::operand const op(static_cast<std::uint16_t>(raw_operand));
     cpu.set_pc(init_pc + 1 + op.size);
 
     constexpr bool add_cycle_on_page_cross = NumCycles.increment_on_page_cross;
-    operand_access<Bus, AddrModeTag, add_cycle_on_page_cross> op_access(cpu, op);
+    operand_access<Cpu, AddrModeTag, add_cycle_on_page_cross> op_access(cpu, op);
 
-    cpu.template disasm_callback<InstTag, AddrModeTag, InstType>(opcode, init_pc, op, op_access);
+    cpu.trace().template on_execute<InstTag, AddrModeTag, InstType>(cpu, opcode, init_pc, op, op_access);
 
     if constexpr (std::is_same_v<AddrModeTag, addressing_mode_tags::imp>)
         cpu.op(InstTag{});
@@ -102,8 +361,8 @@ void opcode_decoder<Bus>::execute(vcpu<Bus>& cpu, std::uint8_t opcode) {
     cpu.advance_cycle_counter(NumCycles.value);
 }
 
-template<class Bus>
-void opcode_decoder<Bus>::op_illegal(vcpu<Bus>& cpu, std::uint8_t opcode) {
+template<class Cpu>
+void opcode_decoder<Cpu>::execute_illegal(cpu_type& cpu, std::uint8_t opcode, std::uint32_t /* raw_operand */) {
     throw illegal_opcode(cpu.pc(), opcode);
 }
 
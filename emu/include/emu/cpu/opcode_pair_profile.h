@@ -0,0 +1,135 @@
+#pragma once
+
+#include "emu/address/absolute_address.h"
+#include "emu/cpu/addressing_mode_tags.h"
+#include "emu/cpu/instruction_tags.h"
+#include "emu/cpu/opcode_decoder.h"
+#include "emu/utility/dynamic_array.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace emu::cpu {
+
+/** Number of times an opcode pair was executed. */
+struct opcode_pair_count {
+    std::uint8_t first;
+    std::uint8_t second;
+    std::uint64_t count;
+};
+
+/**
+ * Trace policy that counts consecutively executed opcode pairs. A pair is not counted if its first instruction
+ * is a control transfer, as such a pair can never be fused into a superinstruction.
+ */
+class opcode_pair_profile {
+public:
+    opcode_pair_profile() {
+        std::ranges::fill(my_counts, 0);
+    }
+
+    template<instruction_tag InstTag, addressing_mode_tag AddrMode, instruction_type, class Cpu, class OperandAccess>
+    void on_execute(Cpu const&, std::uint8_t opcode, absolute_address /* pc */,
+        typename AddrMode::operand const&, OperandAccess const&) noexcept
+    {
+        if (my_last_opcode != no_opcode)
+            ++my_counts[my_last_opcode << 8 | opcode];
+
+        my_last_opcode = control_transfer_instruction_tag<InstTag> ? no_opcode : opcode;
+    }
+
+    /** Adds the counts of another profile (e.g., of another ROM) to this one. */
+    void merge(opcode_pair_profile const& other) noexcept {
+        for (std::size_t i = 0; i != num_pairs; ++i)
+            my_counts[i] += other.my_counts[i];
+    }
+
+    /** Returns up to max_count most frequent pairs, most frequent first. */
+    std::vector<opcode_pair_count> top(std::size_t max_count) const {
+        std::vector<opcode_pair_count> pairs;
+        for (std::size_t i = 0; i != num_pairs; ++i) {
+            if (my_counts[i] != 0)
+                pairs.push_back({.first = std::uint8_t(i >> 8), .second = std::uint8_t(i), .count = my_counts[i]});
+        }
+
+        std::ranges::sort(pairs, std::ranges::greater{}, &opcode_pair_count::count);
+        if (pairs.size() > max_count)
+            pairs.resize(max_count);
+
+        return pairs;
+    }
+
+private:
+    static constexpr std::size_t num_pairs = 0x10000;
+    static constexpr std::uint16_t no_opcode = 0x100;
+
+    dynamic_array<std::uint64_t, num_pairs> my_counts;  // Indexed by (first opcode << 8 | second opcode)
+    std::uint16_t my_last_opcode = no_opcode;
+};
+
+/**
+ * Formats opcode pairs as entries of superinstruction_pairs (see superinstructions.h). Pairs that cannot be fused
+ * are skipped.
+ */
+template<class Cpu>
+std::string to_superinstruction_table(std::span<opcode_pair_count const> pairs) {
+    std::string table;
+    for (opcode_pair_count const& pair : pairs) {
+        if (!opcode_decoder<Cpu>::is_fusable_pair(pair.first, pair.second))
+            continue;
+
+        disasm_info const first = opcode_decoder<Cpu>::disassemble(pair.first, absolute_address{0}, 0);
+        disasm_info const second = opcode_decoder<Cpu>::disassemble(pair.second, absolute_address{0}, 0);
+
+        table += std::format("    {{0x{:02X}, 0x{:02X}}},  //{} {} /{} {}\n", pair.first, pair.second,
+            first.instr_name, first.addr_mode, second.instr_name, second.addr_mode);
+    }
+
+    return table;
+}
+
+/**
+ * Generates superinstructions.h from opcode pairs (see to_superinstruction_table()). The corpus description names
+ * the profiled ROMs in the header comment.
+ */
+template<class Cpu>
+std::string to_superinstructions_header(std::span<opcode_pair_count const> pairs, std::string_view corpus) {
+    std::string header =
+        "#pragma once\n"
+        "\n"
+        "#include <array>\n"
+        "#include <cstdint>\n"
+        "\n"
+        "namespace emu::cpu {\n"
+        "\n"
+        "/** Pair of opcodes executed one right after the other. */\n"
+        "struct opcode_pair {\n"
+        "    std::uint8_t first;\n"
+        "    std::uint8_t second;\n"
+        "};\n"
+        "\n"
+        "/**\n"
+        " * Opcode pairs that are fused into superinstructions (see opcode_decoder::fuse()), most frequent first. Pairs\n"
+        " * that cannot be fused (see opcode_decoder::is_fusable_pair()) are rejected at compile time.\n"
+        " *\n"
+        " * Generated by app_profile from " + std::string(corpus) + ". Do not edit.\n"
+        " */\n"
+        "inline constexpr auto superinstruction_pairs = std::to_array<opcode_pair>({\n";
+
+    header += to_superinstruction_table<Cpu>(pairs);
+
+    header +=
+        "});\n"
+        "\n"
+        "} // namespace emu::cpu\n";
+
+    return header;
+}
+
+} // namespace emu::cpu
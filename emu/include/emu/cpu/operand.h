@@ -14,8 +14,7 @@ public:
     using value_type = void;
 
 public:
-    template<class Bus>
-    null_operand(absolute_address, Bus const&) {}
+    explicit constexpr null_operand(std::uint16_t /* raw_operand */) noexcept {}
 };
 
 /** One-byte operand. */
@@ -25,8 +24,7 @@ public:
     using value_type = std::uint8_t;
 
 public:
-    template<class Bus>
-    byte_operand(absolute_address pc, Bus& bus) : my_operand(bus.load(pc)) {}
+    explicit constexpr byte_operand(std::uint16_t raw_operand) noexcept : my_operand(static_cast<value_type>(raw_operand)) {}
 
     value_type operator*() const noexcept {
         return my_operand;
@@ -43,8 +41,7 @@ public:
     using value_type = std::uint16_t;
 
 public:
-    template<class Bus>
-    word_operand(absolute_address pc, Bus& bus) : my_operand(bus.load_word(pc)) {}
+    explicit constexpr word_operand(std::uint16_t raw_operand) noexcept : my_operand(raw_operand) {}
 
     value_type operator*() const noexcept {
         return my_operand;
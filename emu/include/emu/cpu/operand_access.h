@@ -3,14 +3,13 @@
 #include "emu/cpu/addressing_mode_tags.h"
 #include "emu/cpu/effective_address.h"
 #include "emu/cpu/operand.h"
-#include "emu/cpu/vcpu.h"
 
 namespace emu::cpu {
 
-template<class Bus, addressing_mode_tag AddrMode, bool AddCycleOnPageCross = false>
+template<class Cpu, addressing_mode_tag AddrMode, bool AddCycleOnPageCross = false>
 class operand_access {
 public:
-    operand_access(vcpu<Bus>& cpu, typename AddrMode::operand op) :
+    operand_access(Cpu& cpu, typename AddrMode::operand op) :
         my_eff_address{effective_address<AddrMode, AddCycleOnPageCross>::get(cpu, op)},
         my_mem(cpu.system_bus())
     {}
@@ -33,13 +32,13 @@ public:
 private:
     abstract_address my_eff_address;
     //mutable std::optional<std::uint8_t> my_value;
-    Bus& my_mem;
+    typename Cpu::bus_type& my_mem;
 };
 
-template<class Bus>
-class operand_access<Bus, addressing_mode_tags::imm> {
+template<class Cpu>
+class operand_access<Cpu, addressing_mode_tags::imm> {
 public:
-    operand_access(vcpu<Bus> const&, byte_operand op) noexcept :
+    operand_access(Cpu const&, byte_operand op) noexcept :
         my_imm_value{*op}
     {}
 
@@ -51,10 +50,10 @@ private:
     std::uint8_t my_imm_value;
 };
 
-template<class Bus>
-class operand_access<Bus, addressing_mode_tags::acc> {
+template<class Cpu>
+class operand_access<Cpu, addressing_mode_tags::acc> {
 public:
-    operand_access(vcpu<Bus>& cpu, null_operand) noexcept :
+    operand_access(Cpu& cpu, null_operand) noexcept :
         my_cpu(cpu)
     {}
 
@@ -67,20 +66,20 @@ public:
     }
 
 public:
-    vcpu<Bus>& my_cpu;
+    Cpu& my_cpu;
 };
 
-template<class Bus>
-class operand_access<Bus, addressing_mode_tags::imp> {
+template<class Cpu>
+class operand_access<Cpu, addressing_mode_tags::imp> {
 public:
-    operand_access(vcpu<Bus> const&, null_operand) noexcept
+    operand_access(Cpu const&, null_operand) noexcept
     {}
 };
 
-template<class Bus>
-class operand_access<Bus, addressing_mode_tags::rel> {
+template<class Cpu>
+class operand_access<Cpu, addressing_mode_tags::rel> {
 public:
-    operand_access(vcpu<Bus> const&, byte_operand op) noexcept :
+    operand_access(Cpu const&, byte_operand op) noexcept :
         my_rel_address{static_cast<std::int8_t>(*op)}
     {}
 
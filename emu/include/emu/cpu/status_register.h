@@ -1,13 +1,17 @@
 #pragma once
 
 #include "emu/utility/bit_flags.h"
+#include "emu/utility/bit_ops.h"
 #include "emu/cpu/status_register_flags.h"
 
 #include <cstdint>
 
 namespace emu::cpu {
 
-/** CPU status (flags) register. */
+/**
+ * CPU status (flags) register. With EMU_LAZY_FLAGS, N, Z, C and V are not computed by ALU operations; instead,
+ * the values they are derived from are recorded, and the flags are materialized only when they are read.
+ */
 class status_register : public bit_flags<std::uint8_t> {
 public:
     status_register();
@@ -26,6 +30,24 @@ public:
 
     void set_from_byte_without_break(std::uint8_t flags) noexcept;
 
+#ifdef EMU_LAZY_FLAGS
+    /** Returns the register value with the lazily evaluated flags materialized. */
+    std::uint8_t to_uint() const noexcept;
+
+    bool fn() const noexcept { return is_sign_bit_set(my_n_source); }
+    bool fz() const noexcept { return my_z_source == 0; }
+    bool fc() const noexcept { return is_carry_out_bit_set(my_c_source); }
+    bool fi() const noexcept { return is_set<flags::irq     >(); }
+    bool fd() const noexcept { return is_set<flags::decimal >(); }
+    bool fv() const noexcept { return is_sign_bit_set(my_v_source); }
+
+    status_register& set_n(bool value) noexcept { my_n_source = value ? 0x80 : 0x00; return *this; };
+    status_register& set_z(bool value) noexcept { my_z_source = !value; return *this; };
+    status_register& set_c(bool value) noexcept { my_c_source = value ? 0x100 : 0x000; return *this; };
+    status_register& set_i(bool value) noexcept { set<flags::irq     >(value); return *this; };
+    status_register& set_d(bool value) noexcept { set<flags::decimal >(value); return *this; };
+    status_register& set_v(bool value) noexcept { my_v_source = value ? 0x80 : 0x00; return *this; };
+#else
     bool fn() const noexcept { return is_set<flags::negative>(); }
     bool fz() const noexcept { return is_set<flags::zero    >(); }
     bool fc() const noexcept { return is_set<flags::carry   >(); }
@@ -39,6 +61,7 @@ public:
     status_register& set_i(bool value) noexcept { set<flags::irq     >(value); return *this; };
     status_register& set_d(bool value) noexcept { set<flags::decimal >(value); return *this; };
     status_register& set_v(bool value) noexcept { set<flags::overflow>(value); return *this; };
+#endif
 
 private:
     enum class flags : underlying_type {
@@ -51,6 +74,13 @@ private:
         overflow = 0b0100'0000,  // V - Overflow flag
         negative = 0b1000'0000   // N - Negative flag
     };
+
+#ifdef EMU_LAZY_FLAGS
+    std::uint8_t  my_n_source = 0x00;  // N is bit 7
+    std::uint8_t  my_z_source = 0x01;  // Z is set iff the value is zero
+    std::uint16_t my_c_source = 0x000; // C is bit 8
+    std::uint8_t  my_v_source = 0x00;  // V is bit 7
+#endif
 };
 
 } // namespace emu::cpu
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace emu::cpu {
+
+/** Pair of opcodes executed one right after the other. */
+struct opcode_pair {
+    std::uint8_t first;
+    std::uint8_t second;
+};
+
+/**
+ * Opcode pairs that are fused into superinstructions (see opcode_decoder::fuse()), most frequent first. Pairs
+ * that cannot be fused (see opcode_decoder::is_fusable_pair()) are rejected at compile time.
+ *
+ * Generated by app_profile from nestest.nes (600 frames each). Do not edit.
+ */
+inline constexpr auto superinstruction_pairs = std::to_array<opcode_pair>({
+    {0xC5, 0xF0},  // CMP zpg / BEQ rel
+    {0xCA, 0xD0},  // DEX imp / BNE rel
+    {0xC8, 0xD0},  // INY imp / BNE rel
+    {0x88, 0xCA},  // DEY imp / DEX imp
+    {0x88, 0xC8},  // DEY imp / INY imp
+    {0xA9, 0x88},  // LDA imm / DEY imp
+    {0xAD, 0x10},  // LDA abs / BPL rel
+    {0xA9, 0x8D},  // LDA imm / STA abs
+    {0x26, 0xCA},  // ROL zpg / DEX imp
+    {0x4A, 0x26},  // LSR acc / ROL zpg
+    {0xAD, 0x4A},  // LDA abs / LSR acc
+    {0x4A, 0xB0},  // LSR acc / BCS rel
+    {0x4A, 0x4A},  // LSR acc / LSR acc
+    {0x88, 0xD0},  // DEY imp / BNE rel
+    {0xA2, 0x8E},  // LDX imm / STX abs
+    {0xA5, 0xC5},  // LDA zpg / CMP zpg
+    {0x25, 0x85},  // AND zpg / STA zpg
+    {0xAA, 0x45},  // TAX imp / EOR zpg
+    {0xE6, 0xA9},  // INC zpg / LDA imm
+    {0xCA, 0x8E},  // DEX imp / STX abs
+    {0xA5, 0x18},  // LDA zpg / CLC imp
+    {0xA5, 0x4A},  // LDA zpg / LSR acc
+});
+
+} // namespace emu::cpu
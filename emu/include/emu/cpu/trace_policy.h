@@ -0,0 +1,131 @@
+#pragma once
+
+#include "emu/address/absolute_address.h"
+#include "emu/cpu/addressing_mode_tags.h"
+#include "emu/cpu/disassembler.h"
+#include "emu/cpu/instruction_tags.h"
+#include "emu/cpu/opcode_decoder.h"
+#include "emu/cpu/vcpu_state.h"
+#include "emu/utility/dynamic_array.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <string>
+#include <utility>
+
+namespace emu::cpu {
+
+/**
+ * Trace policies. A CPU calls on_execute() of its policy right before an instruction is executed. The policy is
+ * a template parameter of the CPU, so the default no_trace policy compiles to nothing.
+ */
+
+/** Disables tracing. */
+struct no_trace {
+    template<instruction_tag, addressing_mode_tag AddrMode, instruction_type, class Cpu, class OperandAccess>
+    void on_execute(Cpu const&, std::uint8_t /* opcode */, absolute_address /* pc */,
+        typename AddrMode::operand const&, OperandAccess const&) noexcept
+    {}
+};
+
+/** Disassembles every executed instruction and passes it to a callback along with the CPU state. */
+class callback_trace {
+public:
+    using callback_fn = std::function<void(vcpu_state const&, disasm_info const&)>;
+
+    void set_callback(callback_fn fn) {
+        my_callback = std::move(fn);
+    }
+
+    template<instruction_tag InstTag, addressing_mode_tag AddrMode, instruction_type InstType, class Cpu, class OperandAccess>
+    void on_execute(Cpu const& cpu, std::uint8_t opcode, absolute_address pc,
+        typename AddrMode::operand const& op, OperandAccess const& op_access) const
+    {
+        if (!my_callback)
+            return;
+
+        disasm_info const info{
+            .pc = pc,
+            .instr_name = detail::to_instr_name<InstType>(InstTag::name),
+            .addr_mode = AddrMode::name,
+            .bytes = detail::to_bytes_string<AddrMode>(opcode, op),
+            .operand = detail::to_asm_string(AddrMode{}, pc, op, op_access)
+        };
+
+        my_callback(cpu, info);
+    }
+
+private:
+    callback_fn my_callback;
+};
+
+/** Raw CPU state recorded by binary_trace before an instruction is executed. */
+struct trace_record {
+    vcpu_state::cycle_counter_type cycles;
+    std::uint16_t pc;
+    std::uint16_t operand;
+    std::uint8_t opcode;
+    std::uint8_t a;
+    std::uint8_t x;
+    std::uint8_t y;
+    std::uint8_t p;
+    std::uint8_t sp;
+};
+
+/**
+ * Records the last Capacity executed instructions into a ring buffer of fixed-size records. Recording does not
+ * format nor allocate; records are disassembled on demand with to_string().
+ */
+template<std::size_t Capacity>
+class binary_trace {
+public:
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    template<instruction_tag, addressing_mode_tag AddrMode, instruction_type, class Cpu, class OperandAccess>
+    void on_execute(Cpu const& cpu, std::uint8_t opcode, absolute_address pc,
+        typename AddrMode::operand const& op, OperandAccess const&) noexcept
+    {
+        std::uint16_t raw_operand = 0;
+        if constexpr (AddrMode::operand::size != 0)
+            raw_operand = *op;
+
+        my_records[my_next++ & (Capacity - 1)] = {
+            .cycles = cpu.cycle_counter(), .pc = pc.to_uint(), .operand = raw_operand, .opcode = opcode,
+            .a = cpu.a(), .x = cpu.x(), .y = cpu.y(), .p = cpu.flags().to_uint(), .sp = cpu.sp()
+        };
+    }
+
+    /** Returns the number of records available. */
+    std::size_t size() const noexcept {
+        return my_next < Capacity ? my_next : Capacity;
+    }
+
+    /** Calls fn for each available record, from the oldest to the newest. */
+    template<class Fn>
+    void for_each(Fn fn) const {
+        for (std::size_t i = my_next - size(); i != my_next; ++i)
+            fn(my_records[i & (Capacity - 1)]);
+    }
+
+    void clear() noexcept {
+        my_next = 0;
+    }
+
+private:
+    dynamic_array<trace_record, Capacity> my_records;
+    std::size_t my_next = 0;
+};
+
+/** Formats a trace record in the nestest log format. */
+template<class Cpu>
+std::string to_string(trace_record const& record) {
+    disasm_info const info = opcode_decoder<Cpu>::disassemble(record.opcode, absolute_address{record.pc}, record.operand);
+
+    return std::format("{:04X}  {:9s}{:31s}  A:{:02X} X:{:02X} Y:{:02X} P:{:02X} SP:{:02X} CYC:{}",
+        record.pc, info.bytes, info.instr_name + " " + info.operand,
+        record.a, record.x, record.y, record.p, record.sp, record.cycles);
+}
+
+} // namespace emu::cpu
@@ -1,28 +1,34 @@
 #pragma once
 #include "../fwd.h"
 
-#include "emu/cpu/disassembler.h"
+#include "emu/cpu/decoded_instruction_cache.h"
+#include "emu/cpu/fwd.h"
 #include "emu/cpu/opcode_decoder.h"
 #include "emu/cpu/operand.h"
+#include "emu/cpu/trace_policy.h"
 #include "emu/cpu/vcpu_state.h"
 #include "emu/cpu/ivt_traits.h"
 #include "emu/utility/bit_ops.h"
 
 #include <array>
+#include <bitset>
 #include <cstdint>
 #include <format>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <utility>
 
 namespace emu::cpu {
 
-template<class SystemBus>
+template<class SystemBus, class TracePolicy>
 class vcpu : public vcpu_state {
 public:
     using bus_type = SystemBus;
+    using trace_policy = TracePolicy;
 
 public:
     vcpu(SystemBus& bus) : my_bus(bus) {
@@ -40,6 +46,22 @@ public:
     [[noreturn]] void run_at(absolute_address start_pc);
     cycle_counter_type step();
 
+    /**
+     * Executes instructions until at least the given number of cycles elapses. Returns the number of cycles
+     * actually executed, which exceeds the budget by less than the length of the last instruction (or of both
+     * instructions of a superinstruction).
+     */
+    cycle_counter_type run_for(cycle_counter_type num_cycles);
+
+    /** Executes instructions until pred(cpu) returns true. Returns the number of cycles executed. */
+    template<class Predicate>
+    cycle_counter_type run_until(Predicate pred);
+
+    /** Returns the decoded instruction at the current PC. */
+    decoded_instruction<vcpu> fetch_instruction() {
+        return my_decode_cache.fetch(my_bus, pc());
+    }
+
     ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     /** Stack operations. */
 
@@ -52,25 +74,21 @@ public:
     ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     /** Subroutine hooks. */
 
-    std::function<void(vcpu&)> subroutine_hook(absolute_address) const;
-    void add_subroutine_hook(absolute_address, std::function<void(vcpu&)> hook_fn);
+    using hook_fn = std::function<void(vcpu&)>;
 
-    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-    /** Disassembly callback. */
+    /** Returns the hook registered for a subroutine address, or nullptr if there is none. */
+    hook_fn const* subroutine_hook(absolute_address) const;
+    void add_subroutine_hook(absolute_address, hook_fn hook);
 
-    struct disasm_info {
-        absolute_address pc;
-        std::string instr_name;
-        std::string bytes;
-        std::string operand;
-    };
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /** Tracing. */
 
-    template<instruction_tag, addressing_mode_tag AddrMode, instruction_type, class OperandAccess>
-    void disasm_callback(std::uint8_t opcode, absolute_address pc, typename AddrMode::operand const&, OperandAccess const& op_access) const;
+    TracePolicy& trace() noexcept {
+        return my_trace;
+    }
 
-    template<class CallbackFn>
-    void set_exec_callback(CallbackFn fn) {
-        my_exec_callback = fn;
+    TracePolicy const& trace() const noexcept {
+        return my_trace;
     }
 
     SystemBus& system_bus() {
@@ -372,9 +390,8 @@ public:
     void op(instruction_tags::JSR, OperandAccess const& op_access) {
         absolute_address const new_pc = absolute_address(op_access.get());
 
-        std::function<void(vcpu<SystemBus>&)> const hook = subroutine_hook(new_pc);
-        if (hook)
-            hook(*this);
+        if (my_hooked_addresses[new_pc.to_uint()]) [[unlikely]]
+            (*subroutine_hook(new_pc))(*this);
         else {
             absolute_address const pc_m1 = pc() - 1;
 
@@ -501,98 +518,136 @@ public:
 public:
     SystemBus& my_bus;
 
-    /** Instruction execution callback */
-    std::function<void(vcpu const&, disasm_info const&)> my_exec_callback;
+    [[no_unique_address]] TracePolicy my_trace;
 
 private:
     using ivt = ivt_traits<SystemBus>;
 
-    std::unordered_map<absolute_address, std::function<void(vcpu&)>> my_hooks;
+    [[noreturn]] void run_loop();
+    void enter_nmi_handler();
+
+    decoded_instruction_cache<vcpu> my_decode_cache;
+
+    std::bitset<0x10000> my_hooked_addresses;  // Checked on every JSR before looking up my_hooks
+    std::unordered_map<absolute_address, hook_fn> my_hooks;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-template<class SystemBus>
-void vcpu<SystemBus>::reset() {
+template<class SystemBus, class TracePolicy>
+void vcpu<SystemBus, TracePolicy>::reset() {
     vcpu_state::reset();
     set_initial_pc();
 }
 
-template<class SystemBus>
-void vcpu<SystemBus>::run() {
+template<class SystemBus, class TracePolicy>
+void vcpu<SystemBus, TracePolicy>::run() {
+    reset();
+    run_loop();
+}
+
+template<class SystemBus, class TracePolicy>
+void vcpu<SystemBus, TracePolicy>::run_at(absolute_address start_pc) {
     reset();
+    my_pc = start_pc;
+    run_loop();
+}
 
+template<class SystemBus, class TracePolicy>
+void vcpu<SystemBus, TracePolicy>::run_loop() {
     while (true) {
+        if (my_nmi_trig_flag) [[unlikely]]
+            enter_nmi_handler();
+
         absolute_address const old_pc = pc();
-        step();
+        decoded_instruction<vcpu> const instr = fetch_instruction();
+        opcode_decoder<vcpu>::execute(*this, instr);
 
         // TO DO : check in jump
-        if (pc() == old_pc)
+        // A superinstruction returns to its own start if its second instruction branches back to the first one
+        if (pc() == old_pc && !opcode_decoder<vcpu>::is_superinstruction(instr))
             throw infinite_loop(pc());
+
+#ifdef EMU_THREADED_DISPATCH
+        // Returns only when an NMI is pending; the next iteration enters the handler
+        opcode_decoder<vcpu>::run_threaded(*this, std::numeric_limits<cycle_counter_type>::max());
+#endif
     }
 }
 
-template<class SystemBus>
-void vcpu<SystemBus>::run_at(absolute_address start_pc) {
-    reset();
-    my_pc = start_pc;
+template<class SystemBus, class TracePolicy>
+auto vcpu<SystemBus, TracePolicy>::step() -> cycle_counter_type {
+    cycle_counter_type const old_cycles = my_cycles;
 
-    while (true) {
-        absolute_address const old_pc = pc();
+    if (my_nmi_trig_flag) [[unlikely]]
+        enter_nmi_handler();
+
+    opcode_decoder<vcpu>::execute(*this, fetch_instruction());
+
+    return my_cycles - old_cycles;
+}
+
+template<class SystemBus, class TracePolicy>
+auto vcpu<SystemBus, TracePolicy>::run_for(cycle_counter_type num_cycles) -> cycle_counter_type {
+    cycle_counter_type const start_cycles = my_cycles;
+    cycle_counter_type const end_cycles = start_cycles + num_cycles;
+
+    while (my_cycles < end_cycles)
         step();
 
-        if (pc() == old_pc)
-            throw infinite_loop(pc());
-    }
+    return my_cycles - start_cycles;
 }
 
-template<class Bus>
-auto vcpu<Bus>::step() -> cycle_counter_type {
-    cycle_counter_type const old_cycles = my_cycles;
+template<class SystemBus, class TracePolicy>
+template<class Predicate>
+auto vcpu<SystemBus, TracePolicy>::run_until(Predicate pred) -> cycle_counter_type {
+    cycle_counter_type const start_cycles = my_cycles;
 
-    if (my_nmi_trig_flag) [[unlikely]] {
-        my_nmi_trig_flag = false;
+    while (!std::invoke(pred, std::as_const(*this)))
+        step();
 
-        absolute_address const pc_p1 = pc();
-        std::uint8_t const curr_flags = flags().as_byte_without_break();
+    return my_cycles - start_cycles;
+}
 
-        push_address(pc_p1);
-        push(curr_flags);
+template<class SystemBus, class TracePolicy>
+void vcpu<SystemBus, TracePolicy>::enter_nmi_handler() {
+    my_nmi_trig_flag = false;
 
-        flags().set_i(true);
-        set_pc(ivt::nmi(my_bus));
-        advance_cycle_counter(7);
+    absolute_address const pc_p1 = pc();
+    std::uint8_t const curr_flags = flags().as_byte_without_break();
 
-        //std::cout << "starting NMI handler, will return to: " << std::hex << pc_p1.value() << '\n';
-    }
+    push_address(pc_p1);
+    push(curr_flags);
 
-    std::uint8_t const opcode = my_bus.load(pc());
-    opcode_decoder<Bus>::execute(*this, opcode);
+    flags().set_i(true);
+    set_pc(ivt::nmi(my_bus));
+    advance_cycle_counter(7);
 
-    return my_cycles - old_cycles;
+    //std::cout << "starting NMI handler, will return to: " << std::hex << pc_p1.value() << '\n';
 }
 
+
 ///////////////////////////////////////////////////////////////////////////////
 /** Stack operations */
 
-template<class SystemBus>
-void vcpu<SystemBus>::push(std::uint8_t value) {
+template<class SystemBus, class TracePolicy>
+void vcpu<SystemBus, TracePolicy>::push(std::uint8_t value) {
     my_bus.store(my_sp--, std::uint8_t{value});
 }
 
-template<class SystemBus>
-void vcpu<SystemBus>::push_address(absolute_address addr) {
+template<class SystemBus, class TracePolicy>
+void vcpu<SystemBus, TracePolicy>::push_address(absolute_address addr) {
     push(get_hi_byte(addr.to_uint()));
     push(get_lo_byte(addr.to_uint()));
 }
 
-template<class SystemBus>
-std::uint8_t vcpu<SystemBus>::pop() {
+template<class SystemBus, class TracePolicy>
+std::uint8_t vcpu<SystemBus, TracePolicy>::pop() {
     return my_bus.load(++my_sp);
 }
 
-template<class SystemBus>
-absolute_address vcpu<SystemBus>::pop_address() {
+template<class SystemBus, class TracePolicy>
+absolute_address vcpu<SystemBus, TracePolicy>::pop_address() {
     std::uint8_t const value_lo = pop();
     std::uint8_t const value_hi = pop();
 
@@ -602,44 +657,19 @@ absolute_address vcpu<SystemBus>::pop_address() {
 ///////////////////////////////////////////////////////////////////////////////
 /** Subroutine hooks */
 
-template<class SystemBus>
-std::function<void(vcpu<SystemBus>&)> vcpu<SystemBus>::subroutine_hook(absolute_address addr) const {
-    auto const pos = my_hooks.find(addr);
-    if (pos == my_hooks.end())
-        return {};
-    else
-        return pos->second;
-}
+template<class SystemBus, class TracePolicy>
+auto vcpu<SystemBus, TracePolicy>::subroutine_hook(absolute_address addr) const -> hook_fn const* {
+    if (!my_hooked_addresses[addr.to_uint()])
+        return nullptr;
 
-template<class SystemBus>
-void vcpu<SystemBus>::add_subroutine_hook(absolute_address addr, std::function<void(vcpu<SystemBus>&)> hook_fn) {
-    my_hooks.emplace(addr, hook_fn);
+    auto const pos = my_hooks.find(addr);
+    return pos != my_hooks.end() ? &pos->second : nullptr;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-/** Disassembly callback */
-
-template<class SystemBus>
-template<instruction_tag InstTag, addressing_mode_tag AddrModeTag, instruction_type InstType, class OperandAccess>
-void vcpu<SystemBus>::disasm_callback(std::uint8_t opcode, absolute_address pc, typename AddrModeTag::operand const& op, OperandAccess const& op_access) const {
-    if (!my_exec_callback)
-        return;
-
-    auto get_inst_name = [&](char const* name) {
-        if constexpr (InstType == instruction_type::official)
-            return " " + std::string(name);
-        else
-            return "*" + std::string(name);
-    };
-
-    disasm_info const info{
-        .pc = pc,
-        .instr_name = get_inst_name(InstTag::name),
-        .bytes = detail::to_bytes_string<AddrModeTag>(opcode, op),
-        .operand = detail::to_asm_string(AddrModeTag{}, pc, op, op_access)
-    };
-
-    my_exec_callback(*this, info);
+template<class SystemBus, class TracePolicy>
+void vcpu<SystemBus, TracePolicy>::add_subroutine_hook(absolute_address addr, hook_fn hook) {
+    my_hooks.emplace(addr, std::move(hook));
+    my_hooked_addresses.set(addr.to_uint());
 }
 
 } // namespace emu::cpu
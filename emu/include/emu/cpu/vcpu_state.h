@@ -37,7 +37,8 @@ public:
     ///////////////////////////////////////////////////////////////////////////
     /** Cycle counter. */
 
-    using cycle_counter_type = std::uint32_t;
+    /** Master clock in CPU cycles; 64 bits do not wrap around within any realistic emulation session. */
+    using cycle_counter_type = std::uint64_t;
 
     cycle_counter_type cycle_counter() const noexcept;
     void advance_cycle_counter(cycle_counter_type num_cycles = 1) noexcept;
@@ -47,6 +48,9 @@ public:
 
     void set_nmi_flag() noexcept;
 
+    /** Returns true if an NMI is pending and will be serviced before the next instruction. */
+    bool is_nmi_pending() const noexcept;
+
 protected:
     cycle_counter_type my_cycles = 7;       // Cycle counter
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "emu/cpu/fwd.h"
 #include "emu/mapper/concepts.h"
 
 #include <cstdint>
@@ -9,13 +10,6 @@ namespace emu {
 
 class absolute_address;
 
-namespace cpu {
-    class vcpu_state;
-
-    template<class SystemBus>
-    class vcpu;
-}
-
 namespace apu {
     class vapu;
 }
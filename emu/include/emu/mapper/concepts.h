@@ -1,5 +1,6 @@
 #pragma once
 
+#include "emu/address/page.h"
 #include "emu/address/raw_address.h"
 #include "emu/constants.h"
 #include "emu/ppu/vram/vram_address.h"
@@ -12,10 +13,13 @@
 namespace emu::mapper::concepts {
 
 template<class Mapper>
-concept mapper = requires(Mapper& mapper, abstract_address addr, ppu::vram_address vaddr, std::uint8_t value) {
+concept mapper = requires(Mapper& mapper, abstract_address addr, page_index page, ppu::vram_address vaddr, std::uint8_t value) {
     { mapper.load_prg(addr) } -> std::same_as<std::uint8_t>;
     mapper.store_prg(addr, value);
 
+    { mapper.prg_load_page(page) } -> std::same_as<std::uint8_t const*>;
+    { mapper.prg_store_page(page) } -> std::same_as<std::uint8_t*>;
+
     { mapper.load_chr(vaddr) } -> std::same_as<std::uint8_t>;
     mapper.store_chr(vaddr, value);
 };
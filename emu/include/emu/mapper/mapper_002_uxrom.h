@@ -20,6 +20,12 @@ public:
     std::uint8_t load_prg(abstract_address) const;
     void store_prg(abstract_address, std::uint8_t value);
 
+    /** Returns the memory mapped at a PRG page ($60-$FF) for direct loads, or nullptr if loads need load_prg(). */
+    std::uint8_t const* prg_load_page(page_index) const noexcept;
+
+    /** Returns the memory mapped at a PRG page ($60-$FF) for direct stores, or nullptr if stores need store_prg(). */
+    std::uint8_t* prg_store_page(page_index) noexcept;
+
     std::uint8_t load_chr(ppu::vram_address offset) const;
     void store_chr(ppu::vram_address offset, std::uint8_t value);
 
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "emu/ppu/types.h"
+
+#include <cassert>
+#include <cstdint>
+
+namespace emu::ppu {
+
+/**
+ * Background pixel pipeline holding two tiles worth of pixels, like the 16-bit pattern and attribute shift registers
+ * of the PPU. Each pixel is a color index (attribute bits included) in one byte; the pixel at fine X = 0 is in the
+ * lowest byte of the current tile.
+ */
+class background_shift_register {
+public:
+    /** Shifts the pipeline by one pixel. */
+    void shift() noexcept {
+        my_current = (my_current >> 8) | (my_next << 56);
+        my_next >>= 8;
+    }
+
+    /** Loads the pixels of a tile behind the current one (normally after the previous one was shifted in). */
+    void load(std::uint64_t tile_pixels) noexcept {
+        my_next = tile_pixels;
+    }
+
+    /** Returns the pixel at the given fine X offset (0-7). */
+    color_index pixel(std::uint8_t fine_x) const noexcept {
+        assert(fine_x < 8);
+
+        return color_index{static_cast<std::uint8_t>(my_current >> (8 * fine_x))};
+    }
+
+    /** Returns the pixels of the current tile. */
+    std::uint64_t current() const noexcept {
+        return my_current;
+    }
+
+    /** Returns the pixels of the next tile. */
+    std::uint64_t next() const noexcept {
+        return my_next;
+    }
+
+    /** Replaces the contents of the pipeline. */
+    void set(std::uint64_t current, std::uint64_t next) noexcept {
+        my_current = current;
+        my_next = next;
+    }
+
+private:
+    std::uint64_t my_current = 0;
+    std::uint64_t my_next = 0;
+};
+
+} // namespace emu::ppu
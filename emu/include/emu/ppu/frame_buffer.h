@@ -6,10 +6,11 @@
 #include <SFML/Graphics/Color.hpp>
 #include <SFML/Graphics/Texture.hpp>
 
-#include <condition_variable>
+#include <array>
+#include <atomic>
+#include <bitset>
 #include <cstddef>
 #include <cstdint>
-#include <mutex>
 #include <span>
 
 namespace emu::ppu {
@@ -19,15 +20,17 @@ namespace detail {
 /** 32‑bit RGBA color. */
 struct color_rgba { std::uint8_t r, g, b, a = 255; };
 
+/** Pixel as written by the PPU: system color index in bits 0-5, red, green and blue emphasis in bits 6-8. */
+enum class indexed_pixel : std::uint16_t {};
+
 } // namespace detail
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-class frame_buffer_locked_view;
-
 /**
- * Holds a single frame of pixels using double buffering. Pixels are written
- * sequentially, and the finished frame can be uploaded to an SFML texture.
+ * Hands frames from the emulation thread (producer) to the presenting thread (consumer) with lock-free triple
+ * buffering. Pixels are written sequentially as system color indices with emphasis bits; the producer never waits,
+ * and the consumer always gets the latest complete frame, converted to RGBA, ready to be uploaded to an SFML texture.
  */
 class frame_buffer {
 public:
@@ -37,48 +40,88 @@ public:
 
     using image_span = std::span<detail::color_rgba const, frame_buffer::num_pixels>;
 
+    /** Set of rows of a frame, e.g. the rows that changed since the previous frame. */
+    using row_mask = std::bitset<height>;
+
 public:
     frame_buffer();
 
     /** Writes a pixel and increments the internal write pointer. Must be called (width * height) times per frame. */
     void set_next(system_color_index, color_effects_flags);
 
-    /** Marks the back buffer as ready and notifies a waiting thread. */
-    void release();
+    /**
+     * Publishes the finished frame as the latest one, along with the rows that may differ from the previously
+     * released frame. Called by the producer; never blocks.
+     */
+    void release(row_mask const& changed_rows) noexcept;
+
+    /**
+     * Returns the latest complete frame. If no frame was released since the last call, returns the same frame again.
+     * Called by the consumer; never blocks. The image remains valid until the next call.
+     */
+    image_span acquire() noexcept;
 
-    /** Waits for a completed frame and returns a locked view to the front image buffer. */
-    frame_buffer_locked_view acquire();
+    /**
+     * Returns the rows of the image returned by the last acquire() call that differ from the image returned by the
+     * call before. No rows are set if the frame is identical, e.g. a static screen or a repeated frame.
+     */
+    row_mask const& changed_rows() const noexcept;
+
+    /** Returns the number of frames released but replaced by a newer frame before being acquired. */
+    std::uint64_t dropped_frames() const noexcept;
+
+    /** Returns the number of acquire() calls that returned the same frame as the previous call. */
+    std::uint64_t repeated_frames() const noexcept;
 
 private:
-    friend frame_buffer_locked_view;
-    using image_buffer = dynamic_array<detail::color_rgba, num_pixels>;
+    using indexed_buffer = dynamic_array<detail::indexed_pixel, num_pixels>;
+    using image_buffer   = dynamic_array<detail::color_rgba, num_pixels>;
+
+    /** Converts the changed rows of the front buffer into the RGBA image. */
+    void convert_front_buffer() noexcept;
+
+    /** Converts indexed pixels into RGBA colors. */
+    static void convert_pixels(std::uint16_t const* src, detail::color_rgba* dst, std::size_t count) noexcept;
 
 private:
-    image_buffer::iterator my_curr_pixel;
-    image_buffer my_front_buffer;
-    image_buffer my_back_buffer;
+    static constexpr std::uint8_t buffer_index_mask = 0b0011;
+    static constexpr std::uint8_t fresh_frame_flag  = 0b0100;  // The shared buffer holds a frame not acquired yet
 
-    std::mutex my_mutex;
-    std::condition_variable my_cv;
-    bool my_image_ready = false;
-};
+    std::array<indexed_buffer, 3> my_buffers;
+    std::array<row_mask, 3> my_buffer_rows;  // Rows changed since the frame the consumer holds, at most; per buffer
 
-/** RAII-type object that provides a locked view to the front image buffer. */
-class frame_buffer_locked_view {
-public:
-    /** Releases the lock of the front image buffer. */
-    ~frame_buffer_locked_view();
+    indexed_buffer::iterator my_curr_pixel;  // Owned by the producer
+    std::uint8_t my_back_index = 0;          // Owned by the producer
+    std::uint8_t my_front_index = 1;         // Owned by the consumer
+    image_buffer my_image;                   // Owned by the consumer; RGBA conversion of the front buffer
+    row_mask my_changed_rows;                // Owned by the consumer; rows changed by the last acquire()
 
-    /** Returns a span to the front image buffer's pixel data. */
-    frame_buffer::image_span span() const noexcept;
+    std::atomic<std::uint8_t> my_shared_index = 2;  // Buffer exchanged between producer and consumer, plus fresh flag
 
-private:
-    friend frame_buffer;
-    frame_buffer_locked_view(frame_buffer&);
+    std::atomic<std::uint64_t> my_dropped_frames = 0;
+    std::atomic<std::uint64_t> my_repeated_frames = 0;
 
-private:
-    frame_buffer& my_frame_buffer;
-    std::unique_lock<std::mutex> my_lock;
+    static_assert(std::atomic<std::uint8_t>::is_always_lock_free);
 };
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Calls fn(first_row, num_rows) for each run of consecutive rows in the mask, top to bottom. */
+template<class Fn>
+void for_each_row_range(frame_buffer::row_mask const& rows, Fn&& fn) {
+    std::uint16_t row = 0;
+    while (row < frame_buffer::height) {
+        if (!rows.test(row)) {
+            ++row;
+            continue;
+        }
+
+        std::uint16_t const first = row;
+        while (row < frame_buffer::height && rows.test(row))
+            ++row;
+
+        fn(first, static_cast<std::uint16_t>(row - first));
+    }
+}
+
 } // namespace emu::ppu
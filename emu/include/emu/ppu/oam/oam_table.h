@@ -29,14 +29,14 @@ public:
     /** Returns an iterator past the last OAM entry. */
     const_iterator end() const noexcept;
 
-    /** Writes the entire OAM (usually as part of a DMA transfer) from raw bytes. */
-    void set(const_span) noexcept;
+    /** Writes the entire OAM (usually as part of a DMA transfer) from raw bytes. Returns true if OAM changed. */
+    bool set(const_span) noexcept;
 
     /** Reads a single byte from OAM. */
     std::uint8_t get(oam_address_register) const noexcept;
 
-    /** Writes a single byte into OAM. */
-    void set(oam_address_register, std::uint8_t) noexcept;
+    /** Writes a single byte into OAM. Returns true if OAM changed. */
+    bool set(oam_address_register, std::uint8_t) noexcept;
 
 private:
     span       as_bytes() noexcept;
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "emu/ppu/oam/oam_table.h"
+#include "emu/ppu/scanline_sprite.h"
+#include "emu/ppu/types.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace emu::ppu {
+
+/**
+ * Maps each visible scanline to the sprites that are in range on it. The index is rebuilt from OAM on first use
+ * after it was invalidated, so sprite evaluation does not scan all of OAM on every scanline.
+ */
+class sprite_line_index {
+public:
+    /** Number of scanlines covered by the index. */
+    static constexpr std::uint16_t num_lines = 240;
+
+    /** Sprites in range on a single scanline. */
+    struct line {
+        std::uint8_t num_sprites = 0;
+        bool         overflow    = false;  // More than max_sprites_per_scanline sprites are in range
+
+        std::array<std::uint8_t, max_sprites_per_scanline> sprite_indices;  // In OAM order
+
+        /** Returns the OAM indices of the sprites in range. */
+        std::span<std::uint8_t const> sprites() const noexcept {
+            return std::span(sprite_indices).first(num_sprites);
+        }
+    };
+
+    /** Marks the index as out of date; must be called whenever OAM changes. */
+    void invalidate() noexcept {
+        my_valid = false;
+    }
+
+    /** Returns the sprites in range on a scanline, rebuilding the index first if it is out of date. */
+    line const& at(oam_table const&, sprite_size_mode, std::uint16_t scanline);
+
+private:
+    /** Rebuilds the index from OAM. */
+    void rebuild(oam_table const&, sprite_size_mode) noexcept;
+
+private:
+    std::array<line, num_lines> my_lines;
+
+    sprite_size_mode my_size_mode = sprite_size_mode::s8x8;
+    bool my_valid = false;
+};
+
+} // namespace emu::ppu
@@ -11,6 +11,7 @@ namespace emu::ppu {
 class control_register : private bit_flags<std::uint8_t> {
 public:
     using bit_flags::bit_flags;
+    using bit_flags::to_uint;
 
     /** Returns base nametable index. */
     nametable_index base_nametable_index() const noexcept;
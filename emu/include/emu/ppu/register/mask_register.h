@@ -11,6 +11,7 @@ namespace emu::ppu {
 class mask_register : private bit_flags<std::uint8_t> {
 public:
     using bit_flags::bit_flags;
+    using bit_flags::to_uint;
 
     /** Returns true if background is shown in leftmost 8 pixels. */
     bool show_background_left8() const noexcept;
@@ -15,12 +15,18 @@ public:
     /** Updates the open bus bits from a given open bus value. */
     void set_open_bus_bits(std::uint8_t) noexcept;
 
+    /** Returns true if the sprite overflow flag is set. */
+    bool is_sprite_overflow_set() const noexcept;
+
     /** Clears the sprite overflow flag. */
     void clear_sprite_overflow() noexcept;
 
     /** Sets the sprite overflow flag. */
     void set_sprite_overflow() noexcept;
 
+    /** Returns true if the sprite 0 hit flag is set. */
+    bool is_sprite_zero_hit_set() const noexcept;
+
     /** Clears the sprite 0 hit flag. */
     void clear_sprite_zero_hit() noexcept;
 
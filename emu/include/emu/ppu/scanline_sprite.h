@@ -10,13 +10,17 @@ namespace emu::ppu {
 /** Maximum number of sprites that can be rendered on a single scanline. */
 inline constexpr std::uint8_t max_sprites_per_scanline = 8;
 
-/** Struct that holds the prefetched data for a single sprite row on a scanline. */
-struct scanline_sprite {
-    std::uint8_t    position_x;  // Position of left side of sprite on scanline
-    sprite_priority priority;    // Sprite is behind or in front of background
-    bool            zero_index;  // Sprite has index 0 (for sprite 0 hit detection)
+/** Number of pixels on a scanline. */
+inline constexpr std::uint16_t scanline_width = 256;
 
-    std::array<color_index, 8> pattern;  // Pixel colors
+/** Sprite pixel of a scanline, composited from all sprites in range on the scanline. */
+struct scanline_sprite_pixel {
+    color_index     color      = color_index::backdrop;   // Transparent if no sprite covers the pixel
+    sprite_priority priority   = sprite_priority::behind;  // Sprite is behind or in front of background
+    bool            zero_index = false;                    // Pixel belongs to sprite 0 (for sprite 0 hit detection)
 };
 
+/** Sprite pixels of a whole scanline. */
+using scanline_sprite_pixels = std::array<scanline_sprite_pixel, scanline_width>;
+
 } // namespace emu::ppu
@@ -2,11 +2,15 @@
 
 #include "emu/utility/bit_ops.h"
 
+#include <bit>
 #include <cassert>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <ranges>
+#include <span>
+#include <utility>
 
 namespace emu::ppu {
 
@@ -55,6 +59,15 @@ enum class sprite_priority {
     behind     // Behind background
 };
 
+/** Time of a change to PPU memory or registers; increases with every change (used for dirty-region tracking). */
+using change_stamp = std::uint64_t;
+
+/** Determines whether the PPU writes pixels into the frame buffer. */
+enum class render_mode {
+    full,  // Render every frame (or every Nth frame, see vppu::set_render_interval())
+    none   // Skip color composition and frame buffer writes; only sprite 0 hits and sprite overflow are evaluated
+};
+
 /** Controls grayscale and RGB emphasis effects; read from the mask register. */
 struct color_effects_flags {
     bool grayscale;
@@ -81,23 +94,25 @@ enum class tile_index : std::uint8_t {};
 struct tile_row {
     std::uint8_t lo;  // Low bit plane (controls bit 0 of a pixel's color index)
     std::uint8_t hi;  // High bit plane (controls bit 1 of a pixel's color index)
-
-    void decode(color_index palette, std::span<color_index, 8> dest, bool reverse = false) const {
-        std::uint8_t lo_copy = lo;
-        std::uint8_t hi_copy = hi;
-
-        for (int i = 0; i < 8; ++i) {
-            color_index clr = color_index{static_cast<std::uint8_t>(((hi_copy & 0x01) << 1) | (lo_copy & 0x01))};
-		    lo_copy >>= 1;
-		    hi_copy >>= 1;
-		    if (reverse)
-                dest[7 - i] = bitwise_or(palette, clr);
-            else
-                dest[i] = bitwise_or(palette, clr);
-        }
-    }
 };
 
+/** One 8-pixel row of a tile decoded into 2-bit color indices; byte i (bits 8i-8i+7) holds the i-th pixel from the left. */
+enum class decoded_tile_row : std::uint64_t {};
+
+/** Combines the pixels of a decoded tile row with a palette; byte i of the result holds the i-th pixel's color index. */
+constexpr std::uint64_t apply_palette(decoded_tile_row row, color_index palette) noexcept {
+    return std::to_underlying(row) | std::to_underlying(palette) * std::uint64_t{0x0101010101010101};
+}
+
+/** Combines the pixels of a decoded tile row with a palette and writes them to dest, leftmost pixel first. */
+inline void decode(decoded_tile_row row, color_index palette, std::span<color_index, 8> dest) noexcept {
+    std::uint64_t pixels = apply_palette(row, palette);
+    if constexpr (std::endian::native == std::endian::big)
+        pixels = std::byteswap(pixels);
+
+    std::memcpy(dest.data(), &pixels, sizeof(pixels));
+}
+
 /** Defines the mapping of PPU nametables to physical memory. */
 enum class nametable_mirroring {
     vertical,          // Maps nametables 0 and 2 to page 0; 1 and 3 to page 1
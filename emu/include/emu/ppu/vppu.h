@@ -8,13 +8,16 @@
 #include "emu/ppu/scanline_sprite.h"
 #include "emu/ppu/vppu_base.h"
 #include "emu/ppu/vram/vram.h"
-#include "emu/utility/static_vector.h"
 
+#include <algorithm>
 #include <array>
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <ranges>
+#include <span>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -31,18 +34,73 @@ public:
     /** Writes a byte to a PPU register. */
     void store(abstract_address, std::uint8_t);
 
+    /**
+     * Advances the PPU to the current cycle of the CPU (see set_cpu()) and renders a deferred scanline up to
+     * that dot. Called before every CPU access that changes the PPU state; register reads only render a deferred
+     * scanline if the value read depends on the current dot. Otherwise the PPU only needs to catch up at
+     * next_frame_event_cycle().
+     */
+    void catch_up() {
+        step(my_cpu->cycle_counter() - my_synced_cycles);
+        flush_scanline();
+    }
+
+    /** Selects whether frames are rendered into the frame buffer; side effects on the PPU status stay exact. */
+    void set_render_mode(render_mode mode) noexcept {
+        // When rendering resumes, the next rendered frame is not compared with frames rendered before the switch
+        if (mode == render_mode::full && my_render_mode != render_mode::full)
+            my_has_prev_line_states = false;
+
+        my_render_mode = mode;
+    }
+
+    /** Renders only every Nth frame (N >= 1) in render_mode::full; other frames are handled like render_mode::none. */
+    void set_render_interval(std::uint32_t interval) noexcept {
+        assert(interval > 0);
+        my_render_interval = interval;
+    }
+
+    /** Advances the PPU by a number of CPU cycles. */
     void step(std::size_t cpu_cycles) {
-        for (std::size_t i = 0; i < 3 * cpu_cycles; ++i)
+        my_synced_cycles += cpu_cycles;
+
+        std::size_t num_dots = 3 * cpu_cycles;
+        while (num_dots > 0) {
+            // Dots of a deferred scanline only advance the cycle counter; the line is rendered at once at its end
+            if (my_deferred_scanline && my_cycles.value() < scanline_end_dot) {
+                auto const n = std::min<std::size_t>(num_dots, scanline_end_dot - my_cycles.value());
+                my_cycles.increment(n);
+                num_dots -= n;
+                continue;
+            }
+
             step();
+            --num_dots;
+        }
     }
 
     void step() {
+        if (my_deferred_scanline) [[unlikely]] {
+            assert(my_cycles.value() == scanline_end_dot);
+            render_scanline();
+            my_deferred_scanline = false;
+        }
+
+        if (my_cycles.value() == 0 && my_scanline.is_visible()) {
+            record_line_state();
+
+#ifdef EMU_SCANLINE_RENDERER
+            if (my_mask_reg.show_background() || my_mask_reg.show_sprites())
+                my_deferred_scanline = true;
+#endif
+        }
+
         if (my_scanline.is_visible() && my_cycles.is_visible())
             render_pixel();
 
         if (my_mask_reg.show_background() || my_mask_reg.show_sprites()) {
             if (my_scanline.is_render() && my_cycles.is_bg_fetch()) {
-                std::copy(my_tile_data.begin() + 1, my_tile_data.end(), my_tile_data.begin());
+                my_bg_shifter.shift();
 
                 switch (my_cycles.value() % 8) {
                 case 1:
@@ -77,13 +135,25 @@ public:
             if (my_scanline.is_render() && my_cycles.value() == 257) {
                 if (my_scanline.is_visible())
                     evaluate_sprites();
-                else
-                    my_sprites.clear();
+                else {
+                    std::ranges::fill(my_sprite_pixels, scanline_sprite_pixel{});
+                    my_has_sprite_zero_pixels = false;
+                }
             }
         }
 
         if (my_scanline.value() == 241 && my_cycles.value() == 1) {
-            my_pixel_buff.release();
+            // Frames skipped in between keep the previous rendered frame as the one to compare with
+            if (my_is_frame_rendered) {
+                my_pixel_buff.release(changed_lines());
+                my_has_prev_line_states = true;
+            }
+
+            my_touched_lines.reset();
+
+            my_frame_number = (my_frame_number + 1) % my_render_interval;
+            my_is_frame_rendered = (my_render_mode == render_mode::full && my_frame_number == 0);
+
             my_status_reg.set_vblank();
             if (my_control_reg.enable_vblank_nmi())
                 trigger_vblank_nmi();
@@ -100,22 +170,154 @@ public:
     }
 
 private:
-    std::tuple<bool, sprite_priority, color_index> sprite_pixel() {
+    /** State a visible scanline was rendered with, for comparing frames. */
+    struct line_state {
+        std::uint64_t signature = 0;  // Scroll position, mask and control registers at the start of the scanline
+        change_stamp  stamp = 0;      // Change clock at the start of the scanline
+    };
+
+    using line_states = std::array<line_state, frame_buffer::height>;
+
+    /** Records the state the current scanline is rendered with; called at its first dot. */
+    void record_line_state() noexcept {
+        std::uint64_t const signature = std::uint64_t{my_v_reg.value()}
+                                      | std::uint64_t{my_fine_x} << 16
+                                      | std::uint64_t{my_mask_reg.to_uint()} << 24
+                                      | std::uint64_t{my_control_reg.to_uint()} << 32;
+
+        my_line_states[my_scanline.value()] = {.signature = signature, .stamp = my_change_clock};
+    }
+
+    /**
+     * Returns the scanlines of the finished frame that may differ from the previous rendered frame. A scanline is
+     * unchanged if it was rendered with the same registers, no register was accessed around it in either frame, and
+     * neither the palette, the pattern tables, OAM nor the nametable row it shows changed since the previous frame
+     * rendered it. The current line states become the previous ones.
+     */
+    frame_buffer::row_mask changed_lines() noexcept {
+        constexpr std::uint64_t touched_flag = std::uint64_t{1} << 40;
+
+        frame_buffer::row_mask changed;
+        if (!my_has_prev_line_states)
+            changed.set();
+
+        change_stamp const global_change = std::max({
+            my_vram.my_palette.last_change(),
+            my_vram.my_patterns.last_change(),
+            my_oam_change
+        });
+
+        for (std::uint16_t line = 0; line < frame_buffer::height; ++line) {
+            line_state& curr = my_line_states[line];
+            line_state const& prev = my_prev_line_states[line];
+
+            if (my_touched_lines.test(line))
+                curr.signature |= touched_flag;
+
+            // A scanline shows one tile row (coarse Y in v) of the nametable in v and of its horizontal neighbor
+            auto const coarse_y = static_cast<std::uint8_t>((curr.signature >> 5) & 0x1F);
+            auto const nametable = static_cast<std::uint8_t>((curr.signature >> 10) & 0x03);
+            change_stamp const row_change = std::max(
+                my_vram.my_nametables.row_change(nametable, coarse_y),
+                my_vram.my_nametables.row_change(nametable ^ 1, coarse_y));
+
+            if (((curr.signature | prev.signature) & touched_flag) != 0 || curr.signature != prev.signature ||
+                std::max(global_change, row_change) > prev.stamp)
+                changed.set(line);
+        }
+
+        std::swap(my_line_states, my_prev_line_states);
+        return changed;
+    }
+
+    /**
+     * Renders the deferred part of the current scanline dot by dot, so that the PPU state is exact at the current
+     * dot. Must be called before anything that affects rendering changes mid-scanline.
+     */
+    void flush_scanline() {
+        if (!my_deferred_scanline) [[likely]]
+            return;
+
+        my_deferred_scanline = false;
+
+        auto const dot = my_cycles.value();
+        my_cycles.reset();
+        my_cycles.increment();
+
+        while (my_cycles.value() != dot)
+            step();
+    }
+
+    /**
+     * Returns whether reading a register can observe the current dot of a deferred scanline: $2004 and $2007, and
+     * $2002 while sprite 0 may still hit on this scanline. Other reads return state that rendering does not change.
+     */
+    bool load_observes_dot(std::uint8_t reg) const noexcept {
+        switch (reg) {
+        case 2:
+            return my_has_sprite_zero_pixels && !my_status_reg.is_sprite_zero_hit_set();
+
+        case 4:
+        case 7:
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    /** First dot after the visible part of a scanline. */
+    static constexpr std::uint16_t scanline_end_dot = 257;
+
+    /** Number of background tiles a scanline spans: two prefetched tiles and 32 tiles fetched during the line. */
+    static constexpr std::size_t num_scanline_tiles = 34;
+
+    /**
+     * Renders dots 1-256 of a visible scanline in one pass, with the same results as calling step() for each of
+     * these dots. Requires that no PPU register and no mapper state changed during these dots.
+     */
+    void render_scanline() {
+        // Pixels of each tile, one color index per byte (see background_shift_register)
+        std::array<std::uint64_t, num_scanline_tiles> background;
+        background[0] = my_bg_shifter.current();
+        background[1] = my_bg_shifter.next();
+
+        for (std::size_t tile = 2; tile < num_scanline_tiles; ++tile) {
+            fetch_nametable_byte();
+            fetch_attribute_table_byte();
+            fetch_tile_bytes();
+
+            background[tile] = apply_palette(my_bg_tile, my_attribute_table_byte);
+            my_v_reg.increment_x();
+        }
+
+        my_v_reg.increment_y();
+
+        // Leave the last two tiles in the shift register, just like the dot renderer does
+        my_bg_shifter.set(background[num_scanline_tiles - 2], background[num_scanline_tiles - 1]);
+
+        // Without output, only pixels of sprite 0 can have an effect (a sprite 0 hit)
+        if (!my_is_frame_rendered && !my_has_sprite_zero_pixels)
+            return;
+
+        bool const show_background = my_mask_reg.show_background();
+        for (std::uint16_t x = 0; x < frame_buffer::width; ++x) {
+            color_index pixel = {};
+            if (show_background) {
+                std::uint16_t const offset = x + my_fine_x;
+                pixel = color_index{static_cast<std::uint8_t>(background[offset / 8] >> (8 * (offset % 8)))};
+            }
+
+            output_pixel(x, pixel);
+        }
+    }
+
+    std::tuple<bool, sprite_priority, color_index> sprite_pixel(std::uint16_t x) {
         if (!my_mask_reg.show_sprites())
             return {false, sprite_priority::behind, color_index{0}};
 
-        for (scanline_sprite const& sprite : my_sprites) {
-		    auto offset = (my_cycles.value() - 1) - sprite.position_x;
-		    if (offset < 0 || offset > 7)
-			    continue;
-		    offset = 7 - offset;
-		    color_index color = sprite.pattern[offset];
-		    if (is_transparent(color))
-                continue;
-		    return {sprite.zero_index, sprite.priority, color};
-	    }
-
-        return {false, sprite_priority::behind, color_index{0}};
+        scanline_sprite_pixel const& pixel = my_sprite_pixels[x];
+        return {pixel.zero_index, pixel.priority, pixel.color};
     }
 
     void render_pixel() {
@@ -123,10 +325,15 @@ private:
 
         color_index background = {};
         if (my_mask_reg.show_background()) {
-	        background = my_tile_data[my_fine_x];
+	        background = my_bg_shifter.pixel(my_fine_x);
         }
 
-        auto [zero_index, priority, sprite] = sprite_pixel();
+        output_pixel(x, background);
+    }
+
+    /** Combines the background pixel with sprites and writes the resulting pixel to the frame buffer. */
+    void output_pixel(std::uint16_t x, color_index background) {
+        auto [zero_index, priority, sprite] = sprite_pixel(x);
 
         if (x < 8) {
             if (!my_mask_reg.show_background_left8())
@@ -135,10 +342,15 @@ private:
 		        sprite = {};
 	    }
 
-        color_index color;
-
         bool const b = is_transparent(background);
 	    bool const s = is_transparent(sprite);
+	    if (!b && !s && zero_index && x < 255)
+            my_status_reg.set_sprite_zero_hit();
+
+        if (!my_is_frame_rendered)
+            return;
+
+        color_index color;
 	    if (b && s) {
 	    	color = color_index::backdrop;
 	    } else if (b && !s) {
@@ -146,8 +358,6 @@ private:
 	    } else if (!b && s) {
 	    	color = background;
 	    } else {
-	    	if (zero_index && x < 255)
-                my_status_reg.set_sprite_zero_hit();
 	    	color = (priority == sprite_priority::in_front ? sprite : background);
 	    }
 
@@ -191,38 +401,43 @@ private:
         std::unreachable();
     }
 
-    template<class T, T lo, T hi, class S>
-    std::optional<T> try_bound(S value) {
-        if (std::cmp_less_equal(lo, value) && std::cmp_less(value, hi))
-            return static_cast<T>(value);
-        return {};
-    }
-
+    /**
+     * Composites the sprites in range on the current scanline (see sprite_line_index) into the sprite pixels of
+     * the next rendered scanline. Sprites with lower OAM indices take precedence.
+     */
     template<sprite_size_mode SpriteSize>
     void evaluate_sprites_impl() {
-        my_sprites.clear();
-        for (auto const& [sprite_idx, sprite] : std::views::enumerate(my_oam)) {
-            constexpr std::uint8_t height = sprite_height(SpriteSize);
-            auto const row = try_bound<std::uint8_t, 0, height>(my_scanline.value() - sprite.position_y);
-            if (!row.has_value())
-                continue;
+        std::ranges::fill(my_sprite_pixels, scanline_sprite_pixel{});
+        my_has_sprite_zero_pixels = false;
 
-            if (my_sprites.is_full()) {
-                my_status_reg.set_sprite_overflow();
-                break;
-            }
+        sprite_line_index::line const& line = my_sprite_index.at(my_oam, SpriteSize, my_scanline.value());
+        if (line.overflow)
+            my_status_reg.set_sprite_overflow();
+
+        for (std::uint8_t const sprite_idx : line.sprites()) {
+            oam_entry const& sprite = my_oam.begin()[sprite_idx];
+            int const row = my_scanline.value() - sprite.position_y;
 
-            my_sprites.push_back(scanline_sprite{
-                .position_x = sprite.x_position,
+            scanline_sprite_pixel pixel{
                 .priority   = sprite.attributes.priority(),
-                .zero_index = (sprite_idx == 0),
-                .pattern    = fetch_sprite_pattern<SpriteSize>(sprite, *row)
-            });
+                .zero_index = (sprite_idx == 0)
+            };
+
+            std::array<color_index, 8> const pattern = fetch_sprite_pattern<SpriteSize>(sprite, row);
+            std::uint16_t const end_x = std::min<std::uint16_t>(sprite.x_position + pattern.size(), scanline_width);
+
+            for (std::uint16_t x = sprite.x_position; x < end_x; ++x) {
+                pixel.color = pattern[x - sprite.x_position];
+                if (!is_transparent(pixel.color) && is_transparent(my_sprite_pixels[x].color)) {
+                    my_sprite_pixels[x] = pixel;
+                    my_has_sprite_zero_pixels |= pixel.zero_index;
+                }
+            }
         }
     }
 
     template<sprite_size_mode SpriteSize>
-    tile_row fetch_sprite_pattern_impl(oam_entry const& sprite, int row) {
+    decoded_tile_row fetch_sprite_pattern_impl(oam_entry const& sprite, int row) {
         auto tile_number = sprite.index;
 
 	    if constexpr (SpriteSize == sprite_size_mode::s8x8) {
@@ -230,7 +445,7 @@ private:
 		    if (sprite.attributes.flip_vert())
 			    row = 7 - row;
 
-	        return my_vram.load_tile_row(table_idx, tile_number.index_8x8(), row);
+	        return my_vram.load_tile_row(table_idx, tile_number.index_8x8(), row, sprite.attributes.flip_horz());
 	    } else {
 		    pattern_table_index const table_idx = tile_number.sprite_pt_table_addr_8x16();
 		    if (sprite.attributes.flip_vert())
@@ -241,21 +456,25 @@ private:
                 row -= 8;
 		    }
 
-	        return my_vram.load_tile_row(table_idx, tile_idx, row);
+	        return my_vram.load_tile_row(table_idx, tile_idx, row, sprite.attributes.flip_horz());
 	    }
     }
 
     template<sprite_size_mode SpriteSize>
     std::array<color_index, 8> fetch_sprite_pattern(oam_entry const& sprite, int row) {
-        tile_row const tile = fetch_sprite_pattern_impl<SpriteSize>(sprite, row);
+        decoded_tile_row const tile = fetch_sprite_pattern_impl<SpriteSize>(sprite, row);
 
         std::array<color_index, 8> pattern;
-        tile.decode(sprite.attributes.palette(), pattern, sprite.attributes.flip_horz());
+        decode(tile, sprite.attributes.palette(), pattern);
 
         return pattern;
     }
 
 private:
+    /** Register access handlers; see load() and store(). */
+    using load_fn_ptr  = std::uint8_t (vppu::*)();
+    using store_fn_ptr = void (vppu::*)(std::uint8_t);
+
     /** Reads a byte from VRAM memory. */
     std::uint8_t load_vram();
 
@@ -268,11 +487,24 @@ private:
 
     frame_buffer& my_pixel_buff;
 
-    /** The prefetched data for sprite rows on the current scanline. */
-    static_vector<scanline_sprite, max_sprites_per_scanline> my_sprites;
+    /** Sprite pixels of the scanline being rendered, composited during sprite evaluation. */
+    scanline_sprite_pixels my_sprite_pixels;
+    bool my_has_sprite_zero_pixels = false;
+
+    render_mode   my_render_mode = render_mode::full;
+    std::uint32_t my_render_interval = 1;
+    std::uint32_t my_frame_number = 0;       // Frame number modulo the render interval
+    bool          my_is_frame_rendered = true;  // The current frame is written into the frame buffer
+
+    line_states my_line_states;       // Scanlines of the current frame
+    line_states my_prev_line_states;  // Scanlines of the previous rendered frame
+    bool        my_has_prev_line_states = false;  // False until a frame is rendered, and when rendering resumes
 
     /** Internal read buffer holding the last nametable/pattern byte for CPU read delay. */
     std::uint8_t my_read_buff = {};
+
+    /** True while the visible dots of the current scanline are not rendered yet (see render_scanline()). */
+    bool my_deferred_scanline = false;
 };
 
 } // namespace emu::ppu
@@ -295,51 +527,64 @@ vppu<Mapper>::vppu(Mapper& mapper, nametable_mirroring mirroring, frame_buffer&
 /** Reads a byte from a PPU register. */
 template<class Mapper>
 std::uint8_t vppu<Mapper>::load(abstract_address addr) {
-    abstract_address const mirrored_addr = mirrored_register_address(addr);
-    if (mirrored_addr == status_register_addr)
-        my_open_bus = load_status();
-    else if (mirrored_addr == oam_data_register_addr)
-        my_open_bus = load_oam_data();
-    else if (mirrored_addr == data_register_addr)
-        my_open_bus = load_vram();
-
+    /** Read handlers indexed by register; the value read also becomes the open bus value. */
+    static constexpr std::array<load_fn_ptr, num_registers> load_handlers = {
+        &vppu::load_open_bus,  // $2000, control
+        &vppu::load_open_bus,  // $2001, mask
+        &vppu::load_status,    // $2002, status
+        &vppu::load_open_bus,  // $2003, OAM address
+        &vppu::load_oam_data,  // $2004, OAM data
+        &vppu::load_open_bus,  // $2005, scroll
+        &vppu::load_open_bus,  // $2006, address
+        &vppu::load_vram       // $2007, data
+    };
+
+    // Unlike writes, most reads do not need the deferred scanline rendered up to the current dot
+    std::uint8_t const reg = register_index(addr);
+    step(my_cpu->cycle_counter() - my_synced_cycles);
+    if (load_observes_dot(reg))
+        flush_scanline();
+
+    my_open_bus = (this->*load_handlers[reg])();
     return my_open_bus;
 }
 
 /** Writes a byte to a PPU register. */
 template<class Mapper>
 void vppu<Mapper>::store(abstract_address addr, std::uint8_t value) {
+    /** Write handlers indexed by register. */
+    static constexpr std::array<store_fn_ptr, num_registers> store_handlers = {
+        &vppu::store_ctrl,          // $2000, control
+        &vppu::store_mask,          // $2001, mask
+        &vppu::store_read_only,     // $2002, status
+        &vppu::store_oam_address,   // $2003, OAM address
+        &vppu::store_oam_data,      // $2004, OAM data
+        &vppu::store_scroll,        // $2005, scroll
+        &vppu::store_address,       // $2006, address
+        &vppu::store_vram           // $2007, data
+    };
+
+    catch_up();
+    touch_lines();
     my_open_bus = value;
 
-    abstract_address const mirrored_addr = mirrored_register_address(addr);
-    if (mirrored_addr == control_register_addr)
-        store_ctrl(value);
-    else if (mirrored_addr == mask_register_addr)
-        store_mask(value);
-    else if (mirrored_addr == oam_addr_register_addr)
-        store_oam_address(value);
-    else if (mirrored_addr == oam_data_register_addr)
-        store_oam_data(value);
-    else if (mirrored_addr == scroll_register_addr)
-        store_scroll(value);
-    else if (mirrored_addr == address_register_addr)
-        store_address(value);
-    else if (mirrored_addr == data_register_addr)
-        store_vram(value);
+    (this->*store_handlers[register_index(addr)])(value);
 }
 
-/** Reads a byte from VRAM memory. */
+/** Writes a byte to VRAM memory. */
 template<class Mapper>
 void vppu<Mapper>::store_vram(std::uint8_t value) {
     vram_address const addr = my_v_reg.to_vram_address();
     my_v_reg.increment(my_control_reg.vram_address_increment());
 
-    my_vram.store(addr, value);
+    my_vram.store(addr, value, ++my_change_clock);
 }
 
-/** Writes a byte to VRAM memory. */
+/** Reads a byte from VRAM memory. */
 template<class Mapper>
 std::uint8_t vppu<Mapper>::load_vram() {
+    touch_lines();  // Increments v
+
     vram_address const addr = my_v_reg.to_vram_address();
     my_v_reg.increment(my_control_reg.vram_address_increment());
 
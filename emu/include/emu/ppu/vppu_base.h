@@ -3,9 +3,11 @@
 #include "emu/address.h"
 #include "emu/address/address_mask.h"
 #include "emu/constants.h"
+#include "emu/ppu/background_shift_register.h"
 #include "emu/cpu/vcpu_state.h"
 #include "emu/ppu/cycle_counter.h"
 #include "emu/ppu/oam/oam_table.h"
+#include "emu/ppu/oam/sprite_line_index.h"
 #include "emu/ppu/frame_buffer.h"
 #include "emu/ppu/register/control_register.h"
 #include "emu/ppu/register/latch_register.h"
@@ -19,6 +21,7 @@
 #include "emu/utility/dynamic_array.h"
 
 #include <array>
+#include <bitset>
 #include <cstdint>
 #include <cstddef>
 #include <span>
@@ -30,8 +33,12 @@ public:
     /** View into object attribute memory. */
     using oam_data_span = std::span<std::uint8_t const, ppu_oam_size>;
 
+    using cycle_counter_type = cpu::vcpu_state::cycle_counter_type;
+
+    /** Attaches the CPU that drives the PPU; the PPU is synchronized with the current CPU cycle. */
     void set_cpu(cpu::vcpu_state& cpu) {
         my_cpu = &cpu;
+        my_synced_cycles = cpu.cycle_counter();
     }
 
     /** Reads data from OAM. */
@@ -40,6 +47,24 @@ public:
     /** Writes data into OAM using DMA. */
     void store_oam_data_dma(oam_data_span) noexcept;
 
+    ///////////////////////////////////////////////////////////////////////////
+    /** Idle loop support. */
+
+    /** Returns the number of whole CPU cycles before the v-blank flag is next set or cleared. */
+    std::size_t cpu_cycles_until_frame_event() const noexcept;
+
+    /**
+     * Returns the CPU cycle at which the PPU, once caught up, has set or cleared the v-blank flag (and possibly
+     * requested an NMI). The CPU may run up to this cycle without synchronizing the PPU.
+     */
+    cycle_counter_type next_frame_event_cycle() const noexcept;
+
+    /** Returns true if the status register cannot change before the next frame event and reading it has no effect. */
+    bool is_status_settled() const noexcept;
+
+    /** Returns true if the address is a (mirrored) status register address. */
+    static bool is_status_register_address(abstract_address) noexcept;
+
 protected:
     vppu_base() = default;
 
@@ -49,6 +74,11 @@ protected:
     /** Reads data from the status register. */
     std::uint8_t load_status() noexcept;
 
+    /** Reads a write-only register, which returns the open bus value. */
+    std::uint8_t load_open_bus() noexcept {
+        return my_open_bus;
+    }
+
     ///////////////////////////////////////////////////////////////////////////
     /** Write operations. */
 
@@ -70,10 +100,19 @@ protected:
     /** Writes data into the address register. */
     void store_address(std::uint8_t) noexcept;
 
+    /** Writes a read-only register, which has no effect. */
+    void store_read_only(std::uint8_t) noexcept {}
+
     void store_tile_data() {
-        my_bg_tile.decode(my_attribute_table_byte, std::span<color_index, 8>(my_tile_data.begin() + 8, 8), true);
+        my_bg_shifter.load(apply_palette(my_bg_tile, my_attribute_table_byte));
     }
 
+    ///////////////////////////////////////////////////////////////////////////
+    /** Dirty-region tracking. */
+
+    /** Marks the scanlines whose output a register access at the current dot may affect. */
+    void touch_lines() noexcept;
+
 public:
     void trigger_vblank_nmi();
 
@@ -81,6 +120,11 @@ protected:
     /** Returns a mirrored register address in the canonical PPU range $2000-$2007. */
     static abstract_address mirrored_register_address(abstract_address) noexcept;
 
+    /** Returns the index (0-7) of the register a (mirrored) register address refers to. */
+    static std::uint8_t register_index(abstract_address addr) noexcept {
+        return static_cast<std::uint8_t>((addr & register_addr_index_mask).to_uint());
+    }
+
 protected:
     /** PPU address space, $2000-$3FFF: $2000–$2007 + 8-byte mirror ranges $2008–$3FFF. */
     static constexpr auto register_addr_base_mask   = address_mask<abstract_address>{0x2000};
@@ -95,6 +139,8 @@ protected:
     static constexpr auto address_register_addr     = abstract_address{0x2006};  // Write only
     static constexpr auto data_register_addr        = abstract_address{0x2007};  // Read/Write
 
+    static constexpr std::size_t num_registers = 8;
+
 protected:
     cycle_counter    my_cycles;
     scanline_counter my_scanline;
@@ -119,15 +165,21 @@ protected:
     /** Random access memory. */
 
     ppu::oam_table my_oam;  // $2004, Object attribute memory
+    sprite_line_index my_sprite_index;  // Sprites per scanline; invalidated on every OAM write
 
     cpu::vcpu_state* my_cpu = nullptr;
+    cycle_counter_type my_synced_cycles = 0;  // CPU cycle the PPU has been advanced to
 
     std::uint8_t my_open_bus = {};  // Open bus: The last value read from a readable register or written to any register
 
     tile_index my_nametable_byte = {}; // = tile index latch
     color_index my_attribute_table_byte = color_index::backdrop;
-    tile_row my_bg_tile = {};
-    std::array<color_index, 16> my_tile_data;
+    decoded_tile_row my_bg_tile = {};
+    background_shift_register my_bg_shifter;
+
+    change_stamp my_change_clock = 0;  // Incremented on every change to PPU memory
+    change_stamp my_oam_change = 0;    // Time of the last change to OAM
+    std::bitset<frame_buffer::height> my_touched_lines;  // Scanlines of this frame rendered around register accesses
 
     //pixel_matrix my_pixel_array;
 };
@@ -18,8 +18,11 @@ public:
     /** Reads a byte from the nametable address range. */
     std::uint8_t load(vram_address) const noexcept;
 
-    /** Writes a byte to the nametable address range. */
-    void store(vram_address, std::uint8_t value) noexcept;
+    /** Writes a byte to the nametable address range; if the byte changes, the tile rows it affects get the stamp. */
+    void store(vram_address, std::uint8_t value, change_stamp) noexcept;
+
+    /** Returns the time of the last change to a tile row (0-31) of a logical nametable, attributes included. */
+    change_stamp row_change(std::uint8_t table_index, std::uint8_t row) const noexcept;
 
     /** Updates the mapping of logical nametables. */
     void set_mirroring(nametable_mirroring) noexcept;
@@ -43,9 +46,18 @@ private:
     /** Returns pointers to the start of each logical nametable. */
     base_pointers base_ptrs(nametable_mirroring) noexcept;
 
+    /** Returns the index of the physical nametable that backs a logical nametable. */
+    std::uint8_t physical_index(std::uint8_t table_index) const noexcept;
+
+private:
+    static constexpr std::uint8_t num_tile_rows = 32;  // 30 rows of tiles, 2 rows of attributes
+
+    using row_changes = std::array<std::array<change_stamp, num_tile_rows>, num_nametables>;
+
 private:
     base_pointers my_base_pointers;  // Pointers to the start of each logical nametable
     ciram_storage my_ciram;          // Physical memory for nametables (4KB)
+    row_changes   my_row_changes = {};  // Time of the last change per physical nametable and tile row
 };
 
 } // namespace emu::ppu
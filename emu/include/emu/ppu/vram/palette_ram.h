@@ -17,8 +17,13 @@ public:
     /** Reads a byte from palette RAM. */
     std::uint8_t load(vram_address, std::uint8_t open_bus) const noexcept;
 
-    /** Writes a byte to palette RAM. */
-    void store(vram_address, std::uint8_t) noexcept;
+    /** Writes a byte to palette RAM; if the entry changes, the palette gets the stamp. */
+    void store(vram_address, std::uint8_t, change_stamp) noexcept;
+
+    /** Returns the time of the last change to any palette entry. */
+    change_stamp last_change() const noexcept {
+        return my_last_change;
+    }
 
     /** Returns the system color for the given palette color index. */
     system_color_index operator[](color_index) const noexcept;
@@ -26,6 +31,7 @@ public:
 private:
     using color_index_array = std::array<system_color_index, palette_ram_size>;
     color_index_array my_color_indices = make_default_palette();
+    change_stamp my_last_change = 0;
 
 private:
     /** Returns the default palette used at power-on, before a game modifies it. */
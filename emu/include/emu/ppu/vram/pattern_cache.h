@@ -0,0 +1,50 @@
+#pragma once
+
+#include "emu/ppu/types.h"
+#include "emu/ppu/vram/vram_address.h"
+#include "emu/utility/dynamic_array.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace emu::ppu {
+
+/**
+ * Decoded tile rows of both pattern tables. Each row is kept in a normal and in a horizontally flipped variant, so
+ * background and sprite fetches are single 64-bit loads. The cache must be updated whenever the pattern table
+ * memory changes.
+ */
+class pattern_cache {
+public:
+    /** Decodes a tile row and stores it for the row that contains the given pattern table address. */
+    void store(vram_address, tile_row, change_stamp) noexcept;
+
+    /** Returns the time of the last change to any tile row. */
+    change_stamp last_change() const noexcept {
+        return my_last_change;
+    }
+
+    /** Returns a decoded tile row, horizontally flipped if requested. */
+    decoded_tile_row load(pattern_table_index, tile_index, std::uint8_t row, bool flip_horz = false) const noexcept;
+
+    /** Returns the address of the low bit plane of the tile row that contains the given pattern table address. */
+    static vram_address row_address(vram_address) noexcept;
+
+    /** Total number of tile rows in both pattern tables. */
+    static constexpr std::size_t num_rows = 2 * 256 * 8;
+
+private:
+    /** Returns the index of the tile row that contains the given pattern table address. */
+    static std::size_t row_index(vram_address) noexcept;
+
+    /** Interleaves the bit planes of a tile row into one byte per pixel; Mask selects the pixel order. */
+    template<std::uint64_t Mask>
+    static constexpr decoded_tile_row interleave(tile_row) noexcept;
+
+private:
+    dynamic_array<std::array<decoded_tile_row, 2>, num_rows> my_rows;  // Normal and flipped variant per row
+    change_stamp my_last_change = 0;
+};
+
+} // namespace emu::ppu
@@ -4,6 +4,7 @@
 #include "emu/ppu/vram/palette_ram.h"
 #include "emu/ppu/types.h"
 #include "emu/ppu/vram/nametables.h"
+#include "emu/ppu/vram/pattern_cache.h"
 
 #include <array>
 #include <cstddef>
@@ -20,25 +21,35 @@ public:
     /** Reads a byte from VRAM. */
     std::uint8_t load(vram_address, std::uint8_t open_bus) const;
 
-    /** Writes a byte to VRAM. */
-    void store(vram_address, std::uint8_t);
+    /** Writes a byte to VRAM; changed memory is stamped for dirty-region tracking. */
+    void store(vram_address, std::uint8_t, change_stamp);
 
-    tile_row load_tile_row(pattern_table_index, tile_index, std::uint8_t row) const;
+    /** Returns a decoded tile row from a pattern table, horizontally flipped if requested. */
+    decoded_tile_row load_tile_row(pattern_table_index, tile_index, std::uint8_t row, bool flip_horz = false) const noexcept;
 
 private:
+    /** Decodes the tile row that contains the given pattern table address into the pattern cache. */
+    void cache_tile_row(vram_address, change_stamp);
+
     template<class> friend class vppu_renderer; // TODO : remove
     template<class> friend class vppu;
 
     Mapper& my_mapper;
 
-    nametables  my_nametables;
-    palette_ram my_palette;
+    nametables    my_nametables;
+    palette_ram   my_palette;
+    pattern_cache my_patterns;  // Decoded pattern tables; updated on every pattern table write
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 template<class Mapper>
-vram<Mapper>::vram(Mapper& mapper, nametable_mirroring mirroring) : my_mapper(mapper), my_nametables(mirroring) {}
+vram<Mapper>::vram(Mapper& mapper, nametable_mirroring mirroring) : my_mapper(mapper), my_nametables(mirroring) {
+    for (std::uint16_t addr = 0; addr < vram_nametable_addr.to_uint(); addr += 16) {
+        for (std::uint16_t row = 0; row < 8; ++row)
+            cache_tile_row(vram_address(addr + row), change_stamp{0});
+    }
+}
 
 template<class Mapper>
 std::uint8_t vram<Mapper>::load(vram_address addr, std::uint8_t open_bus) const {
@@ -51,25 +62,31 @@ std::uint8_t vram<Mapper>::load(vram_address addr, std::uint8_t open_bus) const
 }
 
 template<class Mapper>
-void vram<Mapper>::store(vram_address addr, std::uint8_t value) {
-    if (addr < vram_nametable_addr)
+void vram<Mapper>::store(vram_address addr, std::uint8_t value, change_stamp stamp) {
+    if (addr < vram_nametable_addr) {
         my_mapper.store_chr(addr, value);
+        cache_tile_row(addr, stamp);
+    }
     else if (addr < vram_palette_addr)
-        my_nametables.store(addr, value);
+        my_nametables.store(addr, value, stamp);
     else
-        my_palette.store(addr, value);
+        my_palette.store(addr, value, stamp);
 }
 
 template<class Mapper>
-tile_row vram<Mapper>::load_tile_row(pattern_table_index table_idx, tile_index tile_idx, std::uint8_t row) const {
-    vram_address const base_addr = vram_address(std::to_underlying(table_idx) * 0x1000);
-    std::uint16_t const offset = std::to_underlying(tile_idx) * 16 + row;
+decoded_tile_row vram<Mapper>::load_tile_row(pattern_table_index table_idx, tile_index tile_idx, std::uint8_t row,
+    bool flip_horz) const noexcept
+{
+    return my_patterns.load(table_idx, tile_idx, row, flip_horz);
+}
 
-    vram_address const address = base_addr + offset;
+template<class Mapper>
+void vram<Mapper>::cache_tile_row(vram_address addr, change_stamp stamp) {
+    vram_address const address = pattern_cache::row_address(addr);
     std::uint8_t const lo_plane = my_mapper.load_chr(address);
     std::uint8_t const hi_plane = my_mapper.load_chr(address + 8);
 
-    return tile_row{.lo = lo_plane, .hi = hi_plane};
+    my_patterns.store(address, tile_row{.lo = lo_plane, .hi = hi_plane}, stamp);
 }
 
 } // namespace emu::ppu
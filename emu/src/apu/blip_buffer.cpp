@@ -0,0 +1,141 @@
+#include "emu/apu/blip_buffer.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+#include <span>
+
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+namespace emu::apu {
+
+namespace {
+
+using kernel = std::array<float, blip_buffer::kernel_size>;
+using kernel_table = std::array<kernel, blip_buffer::num_phases>;
+
+/**
+ * Returns the step kernels: a Blackman-windowed sinc with a cutoff slightly below the Nyquist frequency, sampled
+ * at each phase of a delta between two samples. Each kernel sums to 1, so the integrated output settles exactly at
+ * the new amplitude.
+ */
+kernel_table make_kernels() noexcept {
+    constexpr double cutoff = 0.45;  // Relative to the sample rate
+    constexpr double half_size = blip_buffer::kernel_size / 2.0;
+    constexpr double pi = std::numbers::pi;
+
+    kernel_table kernels;
+    for (std::size_t phase = 0; phase < blip_buffer::num_phases; ++phase) {
+        double const fraction = static_cast<double>(phase) / blip_buffer::num_phases;
+
+        double sum = 0;
+        std::array<double, blip_buffer::kernel_size> values;
+        for (std::size_t i = 0; i < blip_buffer::kernel_size; ++i) {
+            // Distance from the delta; the delta lies between taps half_size - 1 and half_size
+            double const x = static_cast<double>(i) - (half_size - 1) - fraction;
+
+            double const sinc = (x == 0) ? 1 : std::sin(2 * pi * cutoff * x) / (2 * pi * cutoff * x);
+            double const window = 0.42 + 0.5 * std::cos(pi * x / half_size) + 0.08 * std::cos(2 * pi * x / half_size);
+
+            values[i] = sinc * window;
+            sum += values[i];
+        }
+
+        for (std::size_t i = 0; i < blip_buffer::kernel_size; ++i)
+            kernels[phase][i] = static_cast<float>(values[i] / sum);
+    }
+
+    return kernels;
+}
+
+kernel_table const kernels = make_kernels();
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Creates a buffer converting from a clock rate to a sample rate, holding at most max_samples samples. */
+blip_buffer::blip_buffer(std::uint32_t clock_rate, std::uint32_t sample_rate, std::size_t max_samples) :
+    my_clock_rate(clock_rate),
+    my_deltas(max_samples + kernel_size, 0.0f) {
+    set_sample_rate(sample_rate);
+}
+
+/** Changes the sample rate, which may be fractional. */
+void blip_buffer::set_sample_rate(double sample_rate) noexcept {
+    assert(sample_rate > 0 && sample_rate < my_clock_rate);
+
+    // Round the factor up, so clocks_needed() never falls short
+    my_factor = static_cast<std::uint64_t>(std::ceil(sample_rate * time_unit / my_clock_rate));
+}
+
+/** Adds an amplitude change at a clock time relative to the start of the current block. */
+void blip_buffer::add_delta(std::uint32_t clock_time, float delta) noexcept {
+    std::uint64_t const position = my_offset + clock_time * my_factor;
+    std::size_t const index = position >> time_bits;
+    std::size_t const phase = (position >> (time_bits - phase_bits)) & (num_phases - 1);
+
+    assert(index + kernel_size <= my_deltas.size() && "Block is too long for the buffer");
+    float* const out = my_deltas.data() + index;
+    kernel const& k = kernels[phase];
+
+#ifdef __AVX__
+    // Add the kernel eight samples at a time
+    __m256 const scale = _mm256_set1_ps(delta);
+    for (std::size_t i = 0; i < kernel_size; i += 8) {
+        __m256 const weighted = _mm256_mul_ps(_mm256_loadu_ps(k.data() + i), scale);
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), weighted));
+    }
+#else
+    for (std::size_t i = 0; i < kernel_size; ++i)
+        out[i] += k[i] * delta;
+#endif
+}
+
+/** Returns the number of clocks the current block must last until the given number of samples is available. */
+std::uint32_t blip_buffer::clocks_needed(std::size_t num_samples) const noexcept {
+    std::uint64_t const needed = num_samples * time_unit;
+    if (needed <= my_offset)
+        return 0;
+
+    return static_cast<std::uint32_t>((needed - my_offset + my_factor - 1) / my_factor);
+}
+
+/** Ends the current block at a clock time and starts a new one there. */
+void blip_buffer::end_block(std::uint32_t clock_time) noexcept {
+    my_offset += clock_time * my_factor;
+    assert(samples_available() + kernel_size <= my_deltas.size() && "Block is too long for the buffer");
+}
+
+/** Returns the number of samples that can be read. */
+std::size_t blip_buffer::samples_available() const noexcept {
+    return my_offset >> time_bits;
+}
+
+/** Reads samples into the span, fewer if not as many are available, and returns the number of samples read. */
+std::size_t blip_buffer::read_samples(std::span<float> samples) noexcept {
+    std::size_t const count = std::min(samples.size(), samples_available());
+
+    float amplitude = my_integrator;
+    for (std::size_t i = 0; i < count; ++i) {
+        amplitude += my_deltas[i];
+        samples[i] = amplitude;
+    }
+    my_integrator = amplitude;
+
+    // Keep the deltas of the samples not read yet, including the tails of the kernels beyond the available samples
+    std::size_t const remaining = samples_available() - count + kernel_size;
+    std::copy_n(my_deltas.begin() + count, remaining, my_deltas.begin());
+    std::fill(my_deltas.begin() + remaining, my_deltas.begin() + remaining + count, 0.0f);
+
+    my_offset -= count * time_unit;
+    return count;
+}
+
+} // namespace emu::apu
@@ -0,0 +1,176 @@
+#include "emu/apu/dmc_channel.h"
+
+#include "emu/apu/register/dmc_channel_registers.h"
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+
+namespace emu::apu {
+
+dmc_channel::dmc_channel() {
+    my_timer.set_period(period(0));
+}
+
+/** Returns the current output of the channel (0-127). */
+std::uint8_t dmc_channel::output() const noexcept {
+    return my_output_level;
+}
+
+/** Returns true if sample bytes remain to be fetched. */
+bool dmc_channel::is_active() const noexcept {
+    return my_bytes_remaining > 0;
+}
+
+/** Returns true if the channel raises an IRQ. */
+bool dmc_channel::is_irq_set() const noexcept {
+    return my_irq;
+}
+
+/** Acknowledges the IRQ. */
+void dmc_channel::clear_irq() noexcept {
+    my_irq = false;
+}
+
+/** Enables the channel, restarting the sample if it has ended, or disables it, ending the sample. */
+void dmc_channel::enable(bool enabled) noexcept {
+    if (!enabled) {
+        my_bytes_remaining = 0;
+        return;
+    }
+
+    if (my_bytes_remaining == 0) {
+        restart();
+        fill_sample_buffer();
+    }
+}
+
+/** Sets the function that reads sample bytes from CPU memory. */
+void dmc_channel::set_memory_reader(memory_reader reader) noexcept {
+    my_memory_reader = std::move(reader);
+}
+
+/** Writes a byte to the control register ($4010). */
+void dmc_channel::store_control(std::uint8_t value) noexcept {
+    dmc_control_register const reg(value);
+
+    my_irq_enabled = reg.is_irq_enabled();
+    my_loop_enabled = reg.is_loop_enabled();
+    my_timer.set_period(period(reg.rate_index()));
+
+    if (!my_irq_enabled)
+        my_irq = false;
+}
+
+/** Writes a byte to the direct load register ($4011). */
+void dmc_channel::store_output_level(std::uint8_t value) noexcept {
+    my_output_level = dmc_load_register(value).output_level();
+}
+
+/** Writes a byte to the sample address register ($4012). */
+void dmc_channel::store_sample_address(std::uint8_t value) noexcept {
+    my_sample_address = dmc_sample_address_register(value).sample_address();
+}
+
+/** Writes a byte to the sample length register ($4013). */
+void dmc_channel::store_sample_length(std::uint8_t value) noexcept {
+    my_sample_length = dmc_sample_length_register(value).sample_length();
+}
+
+/** Clocks the timer for a number of CPU cycles. */
+void dmc_channel::clock_timer(std::uint32_t cpu_cycles) noexcept {
+    for (std::uint32_t reloads = my_timer.clock(cpu_cycles); reloads > 0; --reloads) {
+        if (my_silence && my_sample_buffer_empty) {
+            // Nothing to play until the channel is restarted; the output unit only counts bits
+            my_bits_remaining = static_cast<std::uint8_t>((my_bits_remaining - 1 + 8 - reloads % 8) % 8 + 1);
+            return;
+        }
+
+        clock_output();
+    }
+}
+
+/** Returns the number of CPU cycles until the output unit next clocks, or no_step if the output cannot change. */
+std::uint32_t dmc_channel::ticks_until_step() const noexcept {
+    if (my_silence && my_sample_buffer_empty)
+        return channel_base::no_step;
+
+    return my_timer.ticks_until_reload();
+}
+
+/** Returns the number of CPU cycles until the next sample fetch, or no_step if no fetch is due. */
+std::uint32_t dmc_channel::ticks_until_fetch() const noexcept {
+    // The buffer empties, and is refilled at once, when the output unit starts playing its byte
+    if (my_bytes_remaining == 0 || my_sample_buffer_empty)
+        return channel_base::no_step;
+
+    return my_timer.ticks_until_reload() + (my_bits_remaining - 1u) * (my_timer.period() + 1u);
+}
+
+/** Returns the CPU cycles the sample fetches stalled the CPU since the last call. */
+std::uint32_t dmc_channel::take_stall_cycles() noexcept {
+    return std::exchange(my_stall_cycles, 0);
+}
+
+/** Clocks the output unit: applies a delta bit and loads the next sample byte after the last bit. */
+void dmc_channel::clock_output() noexcept {
+    if (!my_silence) {
+        if (my_shift_register & 1) {
+            if (my_output_level <= 125)
+                my_output_level += 2;
+        }
+        else if (my_output_level >= 2)
+            my_output_level -= 2;
+    }
+
+    my_shift_register >>= 1;
+    if (--my_bits_remaining > 0)
+        return;
+
+    my_bits_remaining = 8;
+    my_silence = my_sample_buffer_empty;
+    if (!my_silence) {
+        my_shift_register = my_sample_buffer;
+        my_sample_buffer_empty = true;
+        fill_sample_buffer();
+    }
+}
+
+/** Fetches the next sample byte into the empty sample buffer, if any bytes remain. */
+void dmc_channel::fill_sample_buffer() noexcept {
+    if (!my_sample_buffer_empty || my_bytes_remaining == 0)
+        return;
+
+    assert(my_memory_reader && "DMC channel has no memory reader");
+    my_sample_buffer = my_memory_reader(abstract_address{my_current_address});
+    my_sample_buffer_empty = false;
+    my_stall_cycles += dma_stall_cycles;
+
+    // The address wraps around to $8000
+    my_current_address = (my_current_address == 0xFFFF) ? 0x8000 : my_current_address + 1;
+
+    if (--my_bytes_remaining == 0) {
+        if (my_loop_enabled)
+            restart();
+        else if (my_irq_enabled)
+            my_irq = true;
+    }
+}
+
+/** Restarts the sample from its start address. */
+void dmc_channel::restart() noexcept {
+    my_current_address = my_sample_address;
+    my_bytes_remaining = my_sample_length;
+}
+
+std::uint16_t dmc_channel::period(std::uint8_t rate_index) noexcept {
+    // Output periods in CPU cycles (NTSC); the timer reloads after period + 1 clocks
+    constexpr std::uint16_t rate_table[16] = {
+        428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54,
+    };
+
+    assert(rate_index < 16 && "DMC rate index is out-of-bounds");
+    return static_cast<std::uint16_t>(rate_table[rate_index] - 1);
+}
+
+} // namespace emu::apu
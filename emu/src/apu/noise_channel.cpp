@@ -36,10 +36,18 @@ void noise_channel::store_period(std::uint8_t value) noexcept {
     my_lfsr.set_mode(reg.mode());
 }
 
-/** Clocks the timer. */
-void noise_channel::clock_timer() noexcept {
-    if (my_timer.clock())
-        my_lfsr.advance();
+/** Clocks the timer a number of times. */
+void noise_channel::clock_timer(std::uint32_t ticks) noexcept {
+    if (std::uint32_t const reloads = my_timer.clock(ticks))
+        my_lfsr.advance(reloads);
+}
+
+/** Returns the number of timer clocks until the waveform next steps, or no_step if the step cannot be heard. */
+std::uint32_t noise_channel::ticks_until_step() const noexcept {
+    if (!is_enabled() || !is_active() || my_envelope_unit.volume() == 0)
+        return no_step;
+
+    return my_timer.ticks_until_reload();
 }
 
 /** Clocks the envelope unit. */
@@ -0,0 +1,40 @@
+#include "emu/apu/output_filter.h"
+
+#include <numbers>
+#include <span>
+
+namespace emu::apu {
+
+namespace {
+
+/** Returns the coefficient of a first-order RC high-pass filter with a cutoff frequency. */
+float high_pass_coefficient(double cutoff, double sample_rate) noexcept {
+    double const rc = 1 / (2 * std::numbers::pi * cutoff);
+    double const dt = 1 / sample_rate;
+    return static_cast<float>(rc / (rc + dt));
+}
+
+/** Returns the coefficient of a first-order RC low-pass filter with a cutoff frequency. */
+float low_pass_coefficient(double cutoff, double sample_rate) noexcept {
+    double const rc = 1 / (2 * std::numbers::pi * cutoff);
+    double const dt = 1 / sample_rate;
+    return static_cast<float>(dt / (rc + dt));
+}
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Creates the filters for a sample rate. */
+output_filter::output_filter(double sample_rate) noexcept :
+    my_high_pass_90{high_pass_coefficient(90, sample_rate)},
+    my_high_pass_440{high_pass_coefficient(440, sample_rate)},
+    my_low_pass_14k{low_pass_coefficient(14'000, sample_rate)} {}
+
+/** Filters a block of samples in place, continuing from the previous block. */
+void output_filter::process(std::span<float> samples) noexcept {
+    for (float& sample : samples)
+        sample = my_low_pass_14k.apply(my_high_pass_440.apply(my_high_pass_90.apply(sample)));
+}
+
+} // namespace emu::apu
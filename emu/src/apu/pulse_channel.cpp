@@ -53,10 +53,21 @@ void pulse_channel::store_timer_hi(std::uint8_t value) noexcept {
     my_envelope_unit.schedule_restart();
 }
 
-/** Clocks the timer. */
-void pulse_channel::clock_timer() noexcept {
-    if (my_timer.clock())
-        my_duty_unit.clock();
+/** Clocks the timer a number of times. */
+void pulse_channel::clock_timer(std::uint32_t ticks) noexcept {
+    if (std::uint32_t const reloads = my_timer.clock(ticks))
+        my_duty_unit.clock(reloads);
+}
+
+/** Returns the number of timer clocks until the waveform next steps, or no_step if the step cannot be heard. */
+std::uint32_t pulse_channel::ticks_until_step() const noexcept {
+    if (!is_enabled() || !is_active() || my_timer.period() < 8 || my_timer.period() > 0x7FF)
+        return no_step;
+
+    if (my_envelope_unit.volume() == 0)
+        return no_step;
+
+    return my_timer.ticks_until_reload();
 }
 
 /** Clocks the envelope unit. */
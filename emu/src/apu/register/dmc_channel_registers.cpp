@@ -0,0 +1,43 @@
+#include "emu/apu/register/dmc_channel_registers.h"
+
+#include <cstdint>
+
+namespace emu::apu {
+
+/** Returns true if the channel raises an IRQ when a sample ends without looping. */
+bool dmc_control_register::is_irq_enabled() const noexcept {
+    return is_set<flags::irq_enable>();
+}
+
+/** Returns true if the sample restarts when it ends. */
+bool dmc_control_register::is_loop_enabled() const noexcept {
+    return is_set<flags::loop>();
+}
+
+/** Returns the rate index into the table of output periods. */
+std::uint8_t dmc_control_register::rate_index() const noexcept {
+    return to_uint_masked<flags::rate_index>();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Returns the 7-bit output level. */
+std::uint8_t dmc_load_register::output_level() const noexcept {
+    return to_uint_masked<flags::output_level>();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Returns the address of the first sample byte, $C000-$FFC0 in steps of 64 bytes. */
+std::uint16_t dmc_sample_address_register::sample_address() const noexcept {
+    return static_cast<std::uint16_t>(0xC000 + to_uint() * 64);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Returns the sample length in bytes, 1-4081 in steps of 16 bytes. */
+std::uint16_t dmc_sample_length_register::sample_length() const noexcept {
+    return static_cast<std::uint16_t>(to_uint() * 16 + 1);
+}
+
+} // namespace emu::apu
@@ -22,6 +22,11 @@ bool status_register::is_noise_channel_enabled() const noexcept {
     return is_set<flags::noise_channel>();
 }
 
+/** Returns whether the DMC channel is enabled. */
+bool status_register::is_dmc_channel_enabled() const noexcept {
+    return is_set<flags::dmc_channel>();
+}
+
 /** Sets pulse channel 1 state as active. */
 void status_register::set_pulse1_channel_active(bool state) noexcept {
     set<flags::pulse1_channel>(state);
@@ -42,4 +47,14 @@ void status_register::set_noise_channel_active(bool state) noexcept {
     set<flags::noise_channel>(state);
 }
 
+/** Sets the DMC channel state as active. */
+void status_register::set_dmc_channel_active(bool state) noexcept {
+    set<flags::dmc_channel>(state);
+}
+
+/** Sets the DMC interrupt flag. */
+void status_register::set_dmc_interrupt(bool state) noexcept {
+    set<flags::dmc_interrupt>(state);
+}
+
 } // namespace emu::apu
@@ -42,10 +42,21 @@ void triangle_channel::store_timer_hi(std::uint8_t value) noexcept {
         my_length_counter.reload(reg.length_counter());
 }
 
-/** Clocks the timer. */
-void triangle_channel::clock_timer() {
-    if (my_timer.clock() && my_length_counter.is_non_zero() && my_linear_counter.is_non_zero())
-		my_sequencer.clock();
+/** Clocks the timer a number of times. */
+void triangle_channel::clock_timer(std::uint32_t ticks) noexcept {
+    // The counters only change on frame counter steps, so they gate all reloads alike
+    std::uint32_t const reloads = my_timer.clock(ticks);
+    if (reloads > 0 && my_length_counter.is_non_zero() && my_linear_counter.is_non_zero())
+        my_sequencer.clock(reloads);
+}
+
+/** Returns the number of timer clocks until the waveform next steps, or no_step if the step cannot be heard. */
+std::uint32_t triangle_channel::ticks_until_step() const noexcept {
+    // The sequencer does not advance while a counter is zero
+    if (!is_enabled() || !is_active() || my_timer.period() < 2 || !my_linear_counter.is_non_zero())
+        return no_step;
+
+    return my_timer.ticks_until_reload();
 }
 
 /** Clocks the linear counter. */
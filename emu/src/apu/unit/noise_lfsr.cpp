@@ -17,13 +17,15 @@ void noise_lfsr::set_mode(noise_lfsr_mode mode) noexcept {
     my_mode = mode;
 }
 
-/** Advances the shift register. */
-void noise_lfsr::advance() noexcept {
+/** Advances the shift register a number of times. */
+void noise_lfsr::advance(std::uint32_t count) noexcept {
+    static constexpr std::size_t msb_bit_pos = 14;
     std::uint8_t const offset = std::to_underlying(my_mode);
-    bool const feedback_bit = is_lsb_set(my_state) ^ is_lsb_set(my_state >> offset);
 
-    static constexpr std::size_t msb_bit_pos = 14;
-    my_state = (my_state >> 1) | (feedback_bit << msb_bit_pos);
+    for (; count > 0; --count) {
+        bool const feedback_bit = is_lsb_set(my_state) ^ is_lsb_set(my_state >> offset);
+        my_state = (my_state >> 1) | (feedback_bit << msb_bit_pos);
+    }
 }
 
 } // namespace emu::apu
@@ -29,9 +29,9 @@ void pulse_sequencer::reset() noexcept {
     my_step.reset();
 }
 
-/** Advances the sequencer by one step. */
-void pulse_sequencer::clock() noexcept {
-    my_step.increment();
+/** Advances the sequencer by a number of steps. */
+void pulse_sequencer::clock(std::uint32_t count) noexcept {
+    my_step.increment(count % num_steps);
 }
 
 } // namespace emu::apu
@@ -14,9 +14,9 @@ std::uint8_t triangle_sequencer::output() const noexcept {
     return triangle_table[my_step.value()];
 }
 
-/** Advances the sequencer by one step. */
-void triangle_sequencer::clock() noexcept {
-    my_step.increment();
+/** Advances the sequencer by a number of steps. */
+void triangle_sequencer::clock(std::uint32_t count) noexcept {
+    my_step.increment(count % num_steps);
 }
 
 } // namespace emu::apu
@@ -4,9 +4,13 @@
 #include "emu/apu/register/status_register.h"
 #include "emu/controller/vcontroller.h"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
 
 namespace emu::apu {
 
@@ -37,73 +41,307 @@ vapu::vapu(vcontroller& controller) : my_controller(controller) {}
 
 /** Returns the current output of the APU in the range [0, 1]. */
 float vapu::output() {
+    catch_up();
+    return mix();
+}
+
+/** Sets the buffer that receives the output as band-limited amplitude changes (nullptr for none). */
+void vapu::set_output_buffer(blip_buffer* buffer) noexcept {
+    catch_up();
+
+    // The first buffer starts a block; further buffers join the current one
+    if (!has_buffers())
+        my_block_cycles = 0;
+
+    my_output_buffer = buffer;
+    my_amplitude = 0;
+
+    if (has_buffers())
+        update_output();
+}
+
+/** Sets a buffer that receives the output of a single channel (nullptr for none). */
+void vapu::set_channel_buffer(channel_id channel, blip_buffer* buffer) noexcept {
+    catch_up();
+
+    if (!has_buffers())
+        my_block_cycles = 0;
+
+    auto const index = std::to_underlying(channel);
+    assert(index < num_channels);
+
+    my_num_channel_buffers += (buffer ? 1 : 0) - (my_channel_buffers[index] ? 1 : 0);
+    my_channel_buffers[index] = buffer;
+    my_channel_amplitudes[index] = 0;
+
+    if (has_buffers())
+        update_output();
+}
+
+/** Ends the current block of the output and channel buffers at the current cycle and starts a new one. */
+void vapu::end_block() noexcept {
+    assert(has_buffers());
+
+    catch_up();
+
+    auto const clock_time = static_cast<std::uint32_t>(my_block_cycles);
+    if (my_output_buffer)
+        my_output_buffer->end_block(clock_time);
+
+    for (blip_buffer* const buffer : my_channel_buffers) {
+        if (buffer)
+            buffer->end_block(clock_time);
+    }
+
+    my_block_cycles = 0;
+}
+
+/** Returns the output of the channels mixed into the range [0, 1]. */
+float vapu::mix() noexcept {
     std::uint8_t const output_pls = my_pulse1_channel.output() + my_pulse2_channel.output();
     assert(output_pls < pulse_mixer_table.size() && "Pulse channels output is out-of-bounds");
 
-    std::uint8_t const output_tnd = 3 * my_triangle_channel.output() + 2 * my_noise_channel.output();
+    std::uint8_t const output_tnd = 3 * my_triangle_channel.output() + 2 * my_noise_channel.output()
+                                  + my_dmc_channel.output();
     assert(output_tnd < tnd_mixer_table.size() && "TND channels output is out-of-bounds");
 
     return pulse_mixer_table[output_pls] + tnd_mixer_table[output_tnd];
 }
 
+/** Returns the share of each channel in the mixed output. */
+std::array<float, num_channels> vapu::channel_outputs() noexcept {
+    unsigned const pulse1 = my_pulse1_channel.output();
+    unsigned const pulse2 = my_pulse2_channel.output();
+    unsigned const triangle = 3 * my_triangle_channel.output();
+    unsigned const noise = 2 * my_noise_channel.output();
+    unsigned const dmc = my_dmc_channel.output();
+
+    float const pulse_output = pulse_mixer_table[pulse1 + pulse2];
+    float const tnd_output = tnd_mixer_table[triangle + noise + dmc];
+
+    auto const share = [](float group_output, unsigned level, unsigned group_level) {
+        return group_level == 0 ? 0.0f : group_output * level / group_level;
+    };
+
+    return {
+        share(pulse_output, pulse1, pulse1 + pulse2),
+        share(pulse_output, pulse2, pulse1 + pulse2),
+        share(tnd_output, triangle, triangle + noise + dmc),
+        share(tnd_output, noise, triangle + noise + dmc),
+        share(tnd_output, dmc, triangle + noise + dmc)
+    };
+}
+
 /** Reads a byte from an APU register. */
 std::uint8_t vapu::load(abstract_address addr) noexcept {
-    if (addr == apu_ctrl1_register)
-        return my_controller.load();
-    else if (addr == apu_status_register)
-        return load_status();
-    else
-        return std::uint8_t{0x00};  // Not mapped (TODO: open bus)
+    /** Read handlers indexed by register. */
+    static constexpr auto load_handlers = [] {
+        std::array<load_fn_ptr, num_registers> handlers;
+        handlers.fill(&vapu::load_unmapped);
+
+        handlers[register_index(apu_status_register)] = &vapu::load_status;
+        handlers[register_index(apu_ctrl1_register)]  = &vapu::load_controller;
+
+        return handlers;
+    }();
+
+    catch_up();
+    return (this->*load_handlers[register_index(addr)])();
 }
 
 /** Writes a byte to an APU register. */
 void vapu::store(abstract_address addr, std::uint8_t value) noexcept {
-    if (addr == apu_p1_ctrl_register)
-        my_pulse1_channel.store_control(value);
-    else if (addr == apu_p1_sweep_register)
-        my_pulse1_channel.store_sweep(value);
-    else if (addr == apu_p1_timer_lo_register)
-        my_pulse1_channel.store_timer_lo(value);
-    else if (addr == apu_p1_timer_hi_register)
-        my_pulse1_channel.store_timer_hi(value);
-    else if (addr == apu_p2_ctrl_register)
-        my_pulse2_channel.store_control(value);
-    else if (addr == apu_p2_sweep_register)
-        my_pulse2_channel.store_sweep(value);
-    else if (addr == apu_p2_timer_lo_register)
-        my_pulse2_channel.store_timer_lo(value);
-    else if (addr == apu_p2_timer_hi_register)
-        my_pulse2_channel.store_timer_hi(value);
-    else if (addr == apu_tri_control_register)
-        my_triangle_channel.store_control(value);
-    else if (addr == apu_tri_timer_lo_register)
-        my_triangle_channel.store_timer_lo(value);
-    else if (addr == apu_tri_timer_hi_register)
-        my_triangle_channel.store_timer_hi(value);
-    else if (addr == apu_noise_ctrl_register)
-        my_noise_channel.store_control(value);
-    else if (addr == apu_noise_mode_register)
-        my_noise_channel.store_period(value);
-    else if (addr == apu_noise_timer_register)
-        my_noise_channel.store_timer(value);
-    else if (addr == apu_status_register)
-        store_status(value);
-    else if (addr == apu_ctrl1_register)
-        my_controller.store(value);
-    else if (addr == apu_fc_register)
-        store_frame_counter(value);
+    /** Write handlers indexed by register. */
+    static constexpr std::array<store_fn_ptr, num_registers> store_handlers = {
+        &vapu::store_channel<&vapu::my_pulse1_channel, &pulse_channel::store_control>,         // $4000
+        &vapu::store_channel<&vapu::my_pulse1_channel, &pulse_channel::store_sweep>,           // $4001
+        &vapu::store_channel<&vapu::my_pulse1_channel, &pulse_channel::store_timer_lo>,        // $4002
+        &vapu::store_channel<&vapu::my_pulse1_channel, &pulse_channel::store_timer_hi>,        // $4003
+        &vapu::store_channel<&vapu::my_pulse2_channel, &pulse_channel::store_control>,         // $4004
+        &vapu::store_channel<&vapu::my_pulse2_channel, &pulse_channel::store_sweep>,           // $4005
+        &vapu::store_channel<&vapu::my_pulse2_channel, &pulse_channel::store_timer_lo>,        // $4006
+        &vapu::store_channel<&vapu::my_pulse2_channel, &pulse_channel::store_timer_hi>,        // $4007
+        &vapu::store_channel<&vapu::my_triangle_channel, &triangle_channel::store_control>,    // $4008
+        &vapu::store_unmapped,                                                                 // $4009
+        &vapu::store_channel<&vapu::my_triangle_channel, &triangle_channel::store_timer_lo>,   // $400A
+        &vapu::store_channel<&vapu::my_triangle_channel, &triangle_channel::store_timer_hi>,   // $400B
+        &vapu::store_channel<&vapu::my_noise_channel, &noise_channel::store_control>,          // $400C
+        &vapu::store_unmapped,                                                                 // $400D
+        &vapu::store_channel<&vapu::my_noise_channel, &noise_channel::store_period>,           // $400E
+        &vapu::store_channel<&vapu::my_noise_channel, &noise_channel::store_timer>,            // $400F
+        &vapu::store_channel<&vapu::my_dmc_channel, &dmc_channel::store_control>,              // $4010
+        &vapu::store_channel<&vapu::my_dmc_channel, &dmc_channel::store_output_level>,         // $4011
+        &vapu::store_channel<&vapu::my_dmc_channel, &dmc_channel::store_sample_address>,       // $4012
+        &vapu::store_channel<&vapu::my_dmc_channel, &dmc_channel::store_sample_length>,        // $4013
+        &vapu::store_unmapped,                                                                 // $4014, OAM DMA (bus)
+        &vapu::store_status,                                                                   // $4015
+        &vapu::store_controller,                                                               // $4016
+        &vapu::store_frame_counter,                                                            // $4017
+        &vapu::store_unmapped, &vapu::store_unmapped, &vapu::store_unmapped, &vapu::store_unmapped,
+        &vapu::store_unmapped, &vapu::store_unmapped, &vapu::store_unmapped, &vapu::store_unmapped  // $4018-$401F
+    };
+
+    catch_up();
+    (this->*store_handlers[register_index(addr)])(value);
+    schedule_dma();
+
+    if (has_buffers())
+        update_output();
+}
+
+/** Advances the APU by the cycles accumulated by step(). */
+void vapu::catch_up() noexcept {
+    while (my_pending_cycles > 0) {
+        // Run up to the next frame counter step at most, which may change the state of the channels
+        std::uint64_t const cycles_until_step = frame_counter0.modulus() - frame_counter0.value();
+        std::uint64_t run_cycles = std::min(my_pending_cycles, cycles_until_step);
+
+        // With an output buffer, also stop at each waveform step, where the output changes
+        if (has_buffers())
+            run_cycles = std::min(run_cycles, cycles_until_waveform_step());
+
+        auto const cycles = static_cast<std::uint16_t>(run_cycles);
+        clock_timers(cycles);
+        my_pending_cycles -= cycles;
+        my_block_cycles += cycles;
+
+        if (frame_counter0.increment(cycles))
+            step_frame_counter();
+
+        if (has_buffers())
+            update_output();
+    }
+
+    schedule_dma();
+}
+
+/** Sets the function through which the DMC channel fetches sample bytes from CPU memory. */
+void vapu::set_dma_reader(dmc_channel::memory_reader reader) noexcept {
+    my_dmc_channel.set_memory_reader(std::move(reader));
+}
+
+/** Catches up and returns the CPU cycles DMC sample fetches stalled the CPU since the last call. */
+std::uint64_t vapu::take_stall_cycles() noexcept {
+    catch_up();
+
+    std::uint64_t const stall_cycles = my_dmc_channel.take_stall_cycles();
+    schedule_dma();
+
+    return stall_cycles;
+}
+
+/** Returns true if the APU asserts the CPU IRQ line (DMC interrupt). */
+bool vapu::is_irq_asserted() noexcept {
+    catch_up();
+    return my_dmc_channel.is_irq_set();
+}
+
+/** Returns the number of CPU cycles until the next audible waveform step of any channel. */
+std::uint64_t vapu::cycles_until_waveform_step() const noexcept {
+    // Pulse and noise timers are clocked on odd CPU cycles; the next one is the first if the current one is odd
+    auto const apu_to_cpu_cycles = [this](std::uint32_t ticks) -> std::uint64_t {
+        if (ticks == channel_base::no_step)
+            return std::numeric_limits<std::uint64_t>::max();
+
+        return 2 * std::uint64_t{ticks} - (my_odd_cycle ? 1 : 0);
+    };
+
+    // Triangle and DMC timers are clocked on every CPU cycle
+    auto const cpu_cycles = [](std::uint32_t ticks) -> std::uint64_t {
+        return ticks == channel_base::no_step ? std::numeric_limits<std::uint64_t>::max() : ticks;
+    };
+
+    return std::min({
+        apu_to_cpu_cycles(my_pulse1_channel.ticks_until_step()),
+        apu_to_cpu_cycles(my_pulse2_channel.ticks_until_step()),
+        apu_to_cpu_cycles(my_noise_channel.ticks_until_step()),
+        cpu_cycles(my_triangle_channel.ticks_until_step()),
+        cpu_cycles(my_dmc_channel.ticks_until_step())
+    });
+}
+
+/** Adds the changes of the mixed and channel outputs since the last update to the buffers. */
+void vapu::update_output() noexcept {
+    auto const clock_time = static_cast<std::uint32_t>(my_block_cycles);
+
+    if (my_output_buffer) {
+        float const amplitude = mix();
+        if (amplitude != my_amplitude) {
+            my_output_buffer->add_delta(clock_time, amplitude - my_amplitude);
+            my_amplitude = amplitude;
+        }
+    }
+
+    if (my_num_channel_buffers == 0)
+        return;
+
+    std::array<float, num_channels> const amplitudes = channel_outputs();
+    for (std::size_t i = 0; i < num_channels; ++i) {
+        if (my_channel_buffers[i] && amplitudes[i] != my_channel_amplitudes[i]) {
+            my_channel_buffers[i]->add_delta(clock_time, amplitudes[i] - my_channel_amplitudes[i]);
+            my_channel_amplitudes[i] = amplitudes[i];
+        }
+    }
+}
+
+/** Clocks the channel timers for a number of CPU cycles; the triangle timer runs at twice the rate of others. */
+void vapu::clock_timers(std::uint32_t cpu_cycles) noexcept {
+    // APU cycles (every other CPU cycle) start on an odd CPU cycle
+    std::uint32_t const odd_cycles = cpu_cycles + (my_odd_cycle ? 1 : 0);
+    std::uint32_t const apu_cycles = odd_cycles / 2;
+    my_odd_cycle = (odd_cycles % 2) != 0;
+
+    my_pulse1_channel.clock_timer(apu_cycles);
+    my_pulse2_channel.clock_timer(apu_cycles);
+    my_noise_channel.clock_timer(apu_cycles);
+
+    my_triangle_channel.clock_timer(cpu_cycles);
+    my_dmc_channel.clock_timer(cpu_cycles);
+}
+
+/** Updates the cycle of the next DMC sample fetch; see cycles_until_dma(). */
+void vapu::schedule_dma() noexcept {
+    std::uint64_t const cycle = my_cycle_counter - my_pending_cycles;
+
+    // Stalls of past fetches are due at once
+    if (my_dmc_channel.has_stall_cycles())
+        my_dma_cycle = cycle;
+    else if (std::uint32_t const ticks = my_dmc_channel.ticks_until_fetch(); ticks != channel_base::no_step)
+        my_dma_cycle = cycle + ticks;
+    else
+        my_dma_cycle = std::numeric_limits<std::uint64_t>::max();
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/** Reads data from the controller port. */
+std::uint8_t vapu::load_controller() noexcept {
+    return my_controller.load();
+}
+
+/** Writes data to the controller strobe register. */
+void vapu::store_controller(std::uint8_t value) noexcept {
+    my_controller.store(value);
+}
+
+/** Reads an unmapped or write-only register. */
+std::uint8_t vapu::load_unmapped() noexcept {
+    return std::uint8_t{0x00};  // TODO: open bus
+}
+
+/** Writes an unmapped or read-only register, which has no effect. */
+void vapu::store_unmapped(std::uint8_t) noexcept {}
+
 /** Reads data from the status register. */
-std::uint8_t vapu::load_status() const noexcept {
+std::uint8_t vapu::load_status() noexcept {
     status_register reg;
 
     reg.set_pulse1_channel_active(my_pulse1_channel.is_active());
     reg.set_pulse2_channel_active(my_pulse2_channel.is_active());
     reg.set_triangle_channel_active(my_triangle_channel.is_active());
     reg.set_noise_channel_active(my_noise_channel.is_active());
+    reg.set_dmc_channel_active(my_dmc_channel.is_active());
+    reg.set_dmc_interrupt(my_dmc_channel.is_irq_set());
 
     return reg.to_uint();
 }
@@ -116,6 +354,9 @@ void vapu::store_status(std::uint8_t value) noexcept {
     my_pulse2_channel.enable(reg.is_pulse2_channel_enabled());
     my_triangle_channel.enable(reg.is_triangle_channel_enabled());
     my_noise_channel.enable(reg.is_noise_channel_enabled());
+
+    my_dmc_channel.clear_irq();
+    my_dmc_channel.enable(reg.is_dmc_channel_enabled());
 }
 
 /** Writes data into the frame counter register. */
@@ -27,6 +27,12 @@ auto random_access_memory::page(page_index page_idx) const noexcept -> page_span
     return page_span(my_data.begin() + mirrored_first_addr.to_uint(), page_size);
 }
 
+/** Returns a pointer to the first byte of one (mirrored) RAM page. */
+std::uint8_t* random_access_memory::page_data(page_index page_idx) noexcept {
+    abstract_address const mirrored_first_addr = mirrored_address(abstract_address(page_idx));
+    return my_data.begin() + mirrored_first_addr.to_uint();
+}
+
 /** Returns a mirrored address in the canonical RAM range $0000-$07FF. */
 abstract_address random_access_memory::mirrored_address(abstract_address addr) noexcept {
     constexpr auto addr_mask = address_mask<abstract_address>(ram_size - 1);
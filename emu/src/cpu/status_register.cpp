@@ -10,6 +10,61 @@ namespace emu::cpu {
 status_register::status_register() : bit_flags(bitwise_or(flags::unused, flags::irq)) {
 }
 
+#ifdef EMU_LAZY_FLAGS
+status_register& status_register::set_c_from_value(std::uint16_t value) noexcept {
+    my_c_source = value;
+    return *this;
+}
+
+status_register& status_register::set_z_from_value(std::uint8_t value) noexcept {
+    my_z_source = value;
+    return *this;
+}
+
+status_register& status_register::set_n_from_value(std::uint8_t value) noexcept {
+    my_n_source = value;
+    return *this;
+}
+
+status_register& status_register::set_zn_from_value(std::uint8_t value) noexcept {
+    my_z_source = my_n_source = value;
+    return *this;
+}
+
+status_register& status_register::set_v_from_value(std::uint8_t value) noexcept {
+    my_v_source = static_cast<std::uint8_t>(value << 1);
+    return *this;
+}
+
+status_register& status_register::set_v_from_values(std::uint8_t a, std::uint8_t b, std::uint8_t result) noexcept {
+    // Sign bit is set iff a and b have the same sign that differs from the sign of result
+    my_v_source = (a ^ result) & (b ^ result);
+    return *this;
+}
+
+std::uint8_t status_register::to_uint() const noexcept {
+    return auto(static_cast<bit_flags const&>(*this))
+        .set(flags::negative, fn()).set(flags::zero, fz()).set(flags::carry, fc()).set(flags::overflow, fv())
+        .to_uint();
+}
+
+std::uint8_t status_register::as_byte_with_break() const noexcept {
+    return bit_flags(to_uint()).set(flags::brk, true).to_uint();
+}
+
+std::uint8_t status_register::as_byte_without_break() const noexcept {
+    return bit_flags(to_uint()).set(flags::brk, false).to_uint();
+}
+
+void status_register::set_from_byte_without_break(std::uint8_t flags) noexcept {
+    from_uint(flags);
+    set<flags::brk>(false).set<flags::unused>(true);
+
+    set_n(is_set(flags::negative)).set_z(is_set(flags::zero));
+    set_c(is_set(flags::carry)).set_v(is_set(flags::overflow));
+}
+
+#else
 status_register& status_register::set_c_from_value(std::uint16_t value) noexcept {
     set<flags::carry>(is_carry_out_bit_set(value));
     return *this;
@@ -53,5 +108,6 @@ void status_register::set_from_byte_without_break(std::uint8_t flags) noexcept {
     from_uint(flags);
     set<flags::brk>(false).set<flags::unused>(true);
 }
+#endif
 
 } // namespace emu::cpu
@@ -79,4 +79,8 @@ void vcpu_state::set_nmi_flag() noexcept {
     my_nmi_trig_flag = true;
 }
 
+bool vcpu_state::is_nmi_pending() const noexcept {
+    return my_nmi_trig_flag;
+}
+
 } // namespace emu::cpu
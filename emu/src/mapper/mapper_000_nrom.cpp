@@ -34,6 +34,20 @@ void mapper_000_nrom::store_prg(abstract_address, std::uint8_t) const {
     // ROM - do nothing
 }
 
+std::uint8_t const* mapper_000_nrom::prg_load_page(page_index page_idx) const noexcept {
+    abstract_address const addr{page_idx};
+    if (addr >= prg_rom_start) {
+        std::uint16_t offset = addr.to_uint() - prg_rom_start.to_uint();
+        offset &= (my_prg_rom.size() - 1);
+        return my_prg_rom.data() + offset;
+    } else
+        return nullptr;
+}
+
+std::uint8_t* mapper_000_nrom::prg_store_page(page_index) noexcept {
+    return nullptr;
+}
+
 std::uint8_t mapper_000_nrom::load_chr(ppu::vram_address offset) const {
     return std::uint8_t{my_chr_rom[offset.to_uint()]};
 }
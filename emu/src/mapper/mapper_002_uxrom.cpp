@@ -45,6 +45,31 @@ void mapper_002_uxrom::store_prg(abstract_address addr, std::uint8_t value) {
     }
 }
 
+std::uint8_t const* mapper_002_uxrom::prg_load_page(page_index page_idx) const noexcept {
+    abstract_address const addr{page_idx};
+    if (addr < prg_rom_start) {
+        std::uint16_t const offset = addr.to_uint() - prg_ram_start.to_uint();
+        return my_prg_ram.begin() + offset;
+    }
+    else {
+        std::uint16_t const offset = addr.to_uint() - prg_rom_start.to_uint();
+        if (offset < prg_rom_bank_size)
+            return my_prg_rom_bank0.data() + offset;
+        else
+            return my_prg_rom_bank1.data() + (offset - prg_rom_bank_size);
+    }
+}
+
+std::uint8_t* mapper_002_uxrom::prg_store_page(page_index page_idx) noexcept {
+    abstract_address const addr{page_idx};
+    if (addr < prg_rom_start) {
+        std::uint16_t const offset = addr.to_uint() - prg_ram_start.to_uint();
+        return my_prg_ram.begin() + offset;
+    }
+    else
+        return nullptr;  // Bank switching registers
+}
+
 std::uint8_t mapper_002_uxrom::load_chr(ppu::vram_address offset) const {
     return my_chr_ram[offset.to_uint()];
 }
@@ -4,10 +4,16 @@
 #include "emu/utility/dynamic_array.h"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <ranges>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 namespace emu::ppu {
 
 constexpr detail::color_rgba system_palette[system_palette_size] = {
@@ -29,10 +35,42 @@ constexpr detail::color_rgba system_palette[system_palette_size] = {
     /* 3C */ {0xA0, 0xE2, 0xE2}, {0xA0, 0xA2, 0xA0}, {0x00, 0x00, 0x00}, {0x00, 0x00, 0x00}
 };
 
+namespace {
+
+constexpr std::uint16_t emphasize_red_bit   = 1 << 6;
+constexpr std::uint16_t emphasize_green_bit = 1 << 7;
+constexpr std::uint16_t emphasize_blue_bit  = 1 << 8;
+
+/** Number of distinct indexed pixels: 64 system colors times 8 emphasis combinations. */
+constexpr std::size_t num_indexed_colors = system_palette_size * 8;
+
+/** Returns the RGBA colors of all indexed pixels. */
+constexpr std::array<detail::color_rgba, num_indexed_colors> make_indexed_palette() noexcept {
+    std::array<detail::color_rgba, num_indexed_colors> palette;
+    for (std::size_t pixel = 0; pixel < num_indexed_colors; ++pixel) {
+        detail::color_rgba color = system_palette[pixel % system_palette_size];
+        if (pixel & emphasize_red_bit)   { color.g /= 2; color.b /= 2; }
+        if (pixel & emphasize_green_bit) { color.b /= 2; color.r /= 2; }
+        if (pixel & emphasize_blue_bit)  { color.r /= 2; color.g /= 2; }
+
+        palette[pixel] = color;
+    }
+
+    return palette;
+}
+
+constexpr std::array<detail::color_rgba, num_indexed_colors> indexed_palette = make_indexed_palette();
+
+static_assert(sizeof(detail::color_rgba) == sizeof(std::uint32_t));
+
+} // namespace
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 frame_buffer::frame_buffer() {
-    my_curr_pixel = my_back_buffer.begin();
+    my_curr_pixel = my_buffers[my_back_index].begin();
+    std::ranges::fill(my_image, detail::color_rgba{.r = 0, .g = 0, .b = 0});
+    std::ranges::fill(my_buffer_rows, row_mask{}.set());  // Nothing was converted yet
 }
 
 /** Writes a pixel and increments the internal write pointer. Must be called (width * height) times per frame. */
@@ -41,49 +79,94 @@ void frame_buffer::set_next(system_color_index color_idx, color_effects_flags co
     if (color_eff.grayscale)
         color_idx = bitwise_and(color_idx, system_color_index::grayscale_mask);
 
-    detail::color_rgba color = system_palette[std::to_underlying(color_idx)];
-    if (color_eff.emphasize_red)   { color.g /= 2; color.b /= 2; }
-    if (color_eff.emphasize_green) { color.b /= 2; color.r /= 2; }
-    if (color_eff.emphasize_blue)  { color.r /= 2; color.g /= 2; }
+    std::uint16_t pixel = std::to_underlying(color_idx);
+    if (color_eff.emphasize_red)   pixel |= emphasize_red_bit;
+    if (color_eff.emphasize_green) pixel |= emphasize_green_bit;
+    if (color_eff.emphasize_blue)  pixel |= emphasize_blue_bit;
 
-    assert(my_curr_pixel < my_back_buffer.end());
-    *my_curr_pixel++ = color;
+    assert(my_curr_pixel < my_buffers[my_back_index].end());
+    *my_curr_pixel++ = detail::indexed_pixel{pixel};
 }
 
-/** Marks the back buffer as ready and notifies a waiting thread. */
-void frame_buffer::release() {
-    assert(my_curr_pixel == my_back_buffer.end());
+/**
+ * Publishes the finished frame as the latest one, along with the rows that may differ from the previously released
+ * frame. Called by the producer; never blocks.
+ */
+void frame_buffer::release(row_mask const& changed_rows) noexcept {
+    assert(my_curr_pixel == my_buffers[my_back_index].end());
+
+    // While the previous frame is not acquired, the consumer may skip it and get this frame instead, so its changes
+    // are carried over. The consumer only reads the masks, and never writes a buffer the producer may publish.
+    my_buffer_rows[my_back_index] = changed_rows;
+
+    std::uint8_t const shared = my_shared_index.load(std::memory_order_acquire);
+    if (shared & fresh_frame_flag)
+        my_buffer_rows[my_back_index] |= my_buffer_rows[shared & buffer_index_mask];
 
-    {
-        std::scoped_lock lock(my_mutex);
+    std::uint8_t const old_shared = my_shared_index.exchange(my_back_index | fresh_frame_flag, std::memory_order_acq_rel);
+    if (old_shared & fresh_frame_flag)
+        my_dropped_frames.fetch_add(1, std::memory_order_relaxed);
 
-        std::swap(my_back_buffer, my_front_buffer);
-        my_image_ready = true;
+    my_back_index = old_shared & buffer_index_mask;
+    my_curr_pixel = my_buffers[my_back_index].begin();
+}
+
+/** Returns the latest complete frame. If no frame was released since the last call, returns the same frame again. */
+auto frame_buffer::acquire() noexcept -> image_span {
+    if (my_shared_index.load(std::memory_order_relaxed) & fresh_frame_flag) {
+        std::uint8_t const old_shared = my_shared_index.exchange(my_front_index, std::memory_order_acq_rel);
+        my_front_index = old_shared & buffer_index_mask;
+        my_changed_rows = my_buffer_rows[my_front_index];
+        convert_front_buffer();
+    }
+    else {
+        my_changed_rows.reset();
+        my_repeated_frames.fetch_add(1, std::memory_order_relaxed);
     }
 
-    my_cv.notify_one();
-    my_curr_pixel = my_back_buffer.begin();
+    return image_span(my_image.data(), image_span::extent);
 }
 
-/** Waits for a completed frame and returns a locked view to the image buffer. */
-frame_buffer_locked_view frame_buffer::acquire() {
-    return frame_buffer_locked_view(*this);
+/** Returns the rows of the image returned by the last acquire() call that differ from the image returned before. */
+auto frame_buffer::changed_rows() const noexcept -> row_mask const& {
+    return my_changed_rows;
 }
 
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/** Returns the number of frames released but replaced by a newer frame before being acquired. */
+std::uint64_t frame_buffer::dropped_frames() const noexcept {
+    return my_dropped_frames.load(std::memory_order_relaxed);
+}
 
-/** Releases the lock of the front image buffer. */
-frame_buffer_locked_view::~frame_buffer_locked_view() {
-    my_frame_buffer.my_image_ready = false;
+/** Returns the number of acquire() calls that returned the same frame as the previous call. */
+std::uint64_t frame_buffer::repeated_frames() const noexcept {
+    return my_repeated_frames.load(std::memory_order_relaxed);
 }
 
-/** Returns a span to the front image buffer's pixel data. */
-frame_buffer::image_span frame_buffer_locked_view::span() const noexcept {
-    return frame_buffer::image_span(my_frame_buffer.my_front_buffer.data(), frame_buffer::image_span::extent);
+/** Converts the changed rows of the front buffer into the RGBA image. */
+void frame_buffer::convert_front_buffer() noexcept {
+    auto const* const pixels = reinterpret_cast<std::uint16_t const*>(my_buffers[my_front_index].data());
+
+    for_each_row_range(my_changed_rows, [&](std::uint16_t first_row, std::uint16_t num_rows) {
+        convert_pixels(pixels + first_row * width, my_image.data() + first_row * width, num_rows * width);
+    });
 }
 
-frame_buffer_locked_view::frame_buffer_locked_view(frame_buffer& buff) : my_frame_buffer(buff), my_lock(buff.my_mutex) {
-    my_frame_buffer.my_cv.wait(my_lock, [this]{ return my_frame_buffer.my_image_ready; });
+/** Converts indexed pixels into RGBA colors. */
+void frame_buffer::convert_pixels(std::uint16_t const* src, detail::color_rgba* dst, std::size_t count) noexcept {
+    std::size_t i = 0;
+
+#ifdef __AVX2__
+    // Look up eight pixels at a time with a gather from the palette
+    auto const* const palette = reinterpret_cast<int const*>(indexed_palette.data());
+    for (; i + 8 <= count; i += 8) {
+        __m256i const indices = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i)));
+        __m256i const colors = _mm256_i32gather_epi32(palette, indices, sizeof(detail::color_rgba));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), colors);
+    }
+#endif
+
+    for (; i < count; ++i)
+        dst[i] = indexed_palette[src[i]];
 }
 
 } // namespace emu::ppu
@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <span>
+#include <utility>
 
 namespace emu::ppu {
 
@@ -17,9 +18,13 @@ auto oam_table::end() const noexcept -> const_iterator {
     return std::end(my_data);
 }
 
-/** Writes the entire OAM (usually as part of a DMA transfer) from raw bytes. */
-void oam_table::set(const_span data) noexcept {
+/** Writes the entire OAM (usually as part of a DMA transfer) from raw bytes. Returns true if OAM changed. */
+bool oam_table::set(const_span data) noexcept {
+    if (std::ranges::equal(data, as_bytes()))
+        return false;
+
     std::ranges::copy(data, as_bytes().begin());
+    return true;
 }
 
 /** Reads a single byte from OAM. */
@@ -31,9 +36,9 @@ std::uint8_t oam_table::get(oam_address_register addr) const noexcept {
     return value;
 }
 
-/** Writes a single byte into OAM. */
-void oam_table::set(oam_address_register addr, std::uint8_t value) noexcept {
-    as_bytes()[addr.to_uint()] = value;
+/** Writes a single byte into OAM. Returns true if OAM changed. */
+bool oam_table::set(oam_address_register addr, std::uint8_t value) noexcept {
+    return std::exchange(as_bytes()[addr.to_uint()], value) != value;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,45 @@
+#include "emu/ppu/oam/sprite_line_index.h"
+
+#include "emu/ppu/oam/oam_table.h"
+#include "emu/ppu/types.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <ranges>
+
+namespace emu::ppu {
+
+/** Returns the sprites in range on a scanline, rebuilding the index first if it is out of date. */
+auto sprite_line_index::at(oam_table const& oam, sprite_size_mode size_mode, std::uint16_t scanline) -> line const& {
+    assert(scanline < num_lines);
+
+    if (!my_valid || my_size_mode != size_mode) [[unlikely]]
+        rebuild(oam, size_mode);
+
+    return my_lines[scanline];
+}
+
+/** Rebuilds the index from OAM. */
+void sprite_line_index::rebuild(oam_table const& oam, sprite_size_mode size_mode) noexcept {
+    std::ranges::fill(my_lines, line{});
+
+    std::uint8_t const height = sprite_height(size_mode);
+    for (auto const& [sprite_idx, sprite] : std::views::enumerate(oam)) {
+        std::uint16_t const end_line = std::min<std::uint16_t>(sprite.position_y + height, num_lines);
+
+        for (std::uint16_t scanline = sprite.position_y; scanline < end_line; ++scanline) {
+            line& ln = my_lines[scanline];
+            if (ln.num_sprites == max_sprites_per_scanline)
+                ln.overflow = true;
+            else
+                ln.sprite_indices[ln.num_sprites++] = static_cast<std::uint8_t>(sprite_idx);
+        }
+    }
+
+    my_size_mode = size_mode;
+    my_valid = true;
+}
+
+} // namespace emu::ppu
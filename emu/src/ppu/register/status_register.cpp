@@ -10,6 +10,11 @@ void status_register::set_open_bus_bits(std::uint8_t open_bus) noexcept {
     set_bits<flags::open_bus>(open_bus);
 }
 
+/** Returns true if the sprite overflow flag is set. */
+bool status_register::is_sprite_overflow_set() const noexcept {
+    return is_set<flags::sprite_overflow>();
+}
+
 /** Clears the sprite overflow flag. */
 void status_register::clear_sprite_overflow() noexcept {
     set<flags::sprite_overflow>(false);
@@ -20,6 +25,11 @@ void status_register::set_sprite_overflow() noexcept {
     set<flags::sprite_overflow>(true);
 }
 
+/** Returns true if the sprite 0 hit flag is set. */
+bool status_register::is_sprite_zero_hit_set() const noexcept {
+    return is_set<flags::sprite_zero_hit>();
+}
+
 /** Clears the sprite 0 hit flag. */
 void status_register::clear_sprite_zero_hit() noexcept {
     set<flags::sprite_zero_hit>(false);
@@ -2,6 +2,8 @@
 
 #include "emu/ppu/register/scroll_register.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 
 namespace emu::ppu {
@@ -38,7 +40,10 @@ void vppu_base::store_oam_address(std::uint8_t value) noexcept {
 }
 
 void vppu_base::store_oam_data(std::uint8_t value) {
-    my_oam.set(my_oam_addr_reg++, value);
+    if (my_oam.set(my_oam_addr_reg++, value)) {
+        my_oam_change = ++my_change_clock;
+        my_sprite_index.invalidate();
+    }
 }
 
 void vppu_base::store_scroll(std::uint8_t value) noexcept {
@@ -68,7 +73,28 @@ void vppu_base::store_address(std::uint8_t value) noexcept {
 }
 
 void vppu_base::store_oam_data_dma(oam_data_span oam_data) noexcept {
-    my_oam.set(oam_data);
+    touch_lines();
+
+    if (my_oam.set(oam_data)) {
+        my_oam_change = ++my_change_clock;
+        my_sprite_index.invalidate();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Marks the scanlines whose output a register access at the current dot may affect: the current scanline and the
+ * next one, whose first tiles and sprites are fetched at the end of the current one.
+ */
+void vppu_base::touch_lines() noexcept {
+    if (my_scanline.is_visible()) {
+        my_touched_lines.set(my_scanline.value());
+        if (my_scanline.value() + 1u < frame_buffer::height)
+            my_touched_lines.set(my_scanline.value() + 1u);
+    }
+    else if (my_scanline.is_pre_render())
+        my_touched_lines.set(0);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -77,6 +103,41 @@ void vppu_base::trigger_vblank_nmi() {
     my_cpu->set_nmi_flag();
 }
 
+std::size_t vppu_base::cpu_cycles_until_frame_event() const noexcept {
+    constexpr std::size_t num_dots_per_frame = num_scanlines_per_frame * num_cycles_per_scanline;
+    constexpr std::size_t vblank_set_dot   = 241 * num_cycles_per_scanline + 1;
+    constexpr std::size_t vblank_clear_dot = 261 * num_cycles_per_scanline + 1;
+
+    std::size_t const dot = my_scanline.value() * num_cycles_per_scanline + my_cycles.value();
+    auto const dots_until = [dot](std::size_t event_dot) {
+        return (event_dot + num_dots_per_frame - dot) % num_dots_per_frame;
+    };
+
+    return std::min(dots_until(vblank_set_dot), dots_until(vblank_clear_dot)) / 3;
+}
+
+auto vppu_base::next_frame_event_cycle() const noexcept -> cycle_counter_type {
+    // An event at dot d from now is processed by the step() call after d dots, i.e. within CPU cycle d / 3 + 1
+    return my_synced_cycles + cpu_cycles_until_frame_event() + 1;
+}
+
+bool vppu_base::is_status_settled() const noexcept {
+    if (my_status_reg.is_vblank_set())
+        return false;  // Reading clears the flag
+
+    // Sprite flags may only be set on render scanlines
+    bool const is_rendering = my_mask_reg.show_background() || my_mask_reg.show_sprites();
+    bool const sprite_flags_set = my_status_reg.is_sprite_zero_hit_set() && my_status_reg.is_sprite_overflow_set();
+
+    return !my_scanline.is_render() || !is_rendering || sprite_flags_set;
+}
+
+bool vppu_base::is_status_register_address(abstract_address addr) noexcept {
+    return mirrored_register_address(addr) == status_register_addr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 abstract_address vppu_base::mirrored_register_address(abstract_address addr) noexcept {
     return (addr & register_addr_index_mask) | register_addr_base_mask;
 }
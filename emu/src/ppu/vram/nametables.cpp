@@ -3,6 +3,7 @@
 #include "emu/ppu/types.h"
 #include "emu/ppu/vram/vram_address.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -20,10 +21,32 @@ std::uint8_t nametables::load(vram_address addr) const noexcept {
     return my_base_pointers[nt.table_index][nt.offset_in_table];
 }
 
-/** Writes a byte to the nametable address range. */
-void nametables::store(vram_address addr, std::uint8_t value) noexcept {
+/** Writes a byte to the nametable address range; if the byte changes, the tile rows it affects get the stamp. */
+void nametables::store(vram_address addr, std::uint8_t value, change_stamp stamp) noexcept {
+    constexpr std::uint16_t attribute_table_offset = 0x03C0;
+
     decode_result const nt = decode_nametable_address(addr);
-    my_base_pointers[nt.table_index][nt.offset_in_table] = value;
+
+    std::uint8_t& byte = my_base_pointers[nt.table_index][nt.offset_in_table];
+    if (byte == value)
+        return;
+
+    byte = value;
+
+    auto& rows = my_row_changes[physical_index(nt.table_index)];
+    rows[nt.offset_in_table / num_tile_rows] = stamp;
+
+    // An attribute byte colors a group of 4x4 tiles
+    if (nt.offset_in_table >= attribute_table_offset) {
+        std::uint8_t const first_row = (nt.offset_in_table - attribute_table_offset) / 8 * 4;
+        std::fill_n(rows.begin() + first_row, 4, stamp);
+    }
+}
+
+/** Returns the time of the last change to a tile row (0-31) of a logical nametable, attributes included. */
+change_stamp nametables::row_change(std::uint8_t table_index, std::uint8_t row) const noexcept {
+    assert(table_index < num_nametables && row < num_tile_rows);
+    return my_row_changes[physical_index(table_index)][row];
 }
 
 /** Updates the mapping of logical nametables. */
@@ -45,6 +68,11 @@ auto nametables::decode_nametable_address(vram_address addr) noexcept -> decode_
     return nt;
 }
 
+/** Returns the index of the physical nametable that backs a logical nametable. */
+std::uint8_t nametables::physical_index(std::uint8_t table_index) const noexcept {
+    return static_cast<std::uint8_t>((my_base_pointers[table_index] - my_ciram.data()) / nametable_size);
+}
+
 /** Returns pointers to the start of each logical nametable. */
 auto nametables::base_ptrs(nametable_mirroring mirroring) noexcept -> base_pointers {
     auto const ptr = [this](std::uint8_t index) {
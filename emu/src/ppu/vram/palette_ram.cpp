@@ -6,6 +6,7 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <utility>
 
 namespace emu::ppu {
 
@@ -17,12 +18,13 @@ std::uint8_t palette_ram::load(vram_address addr, std::uint8_t open_bus) const n
     return std::uint8_t{std::to_underlying(color_idx)} | (open_bus & open_bus_mask);
 }
 
-/** Writes a byte to palette RAM. */
-void palette_ram::store(vram_address addr, std::uint8_t value) noexcept {
+/** Writes a byte to palette RAM; if the entry changes, the palette gets the stamp. */
+void palette_ram::store(vram_address addr, std::uint8_t value, change_stamp stamp) noexcept {
     constexpr auto color_mask = std::uint8_t{system_palette_size - 1};
 
-    std::uint8_t const color_idx = value & color_mask;
-    my_color_indices[entry_index(addr)] = system_color_index{color_idx};
+    auto const color_idx = system_color_index{static_cast<std::uint8_t>(value & color_mask)};
+    if (std::exchange(my_color_indices[entry_index(addr)], color_idx) != color_idx)
+        my_last_change = stamp;
 }
 
 /** Returns the system color for the given palette color index. */
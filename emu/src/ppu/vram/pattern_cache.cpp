@@ -0,0 +1,75 @@
+#include "emu/ppu/vram/pattern_cache.h"
+
+#include "emu/ppu/types.h"
+#include "emu/ppu/vram/vram_address.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace emu::ppu {
+
+namespace {
+
+/** Masks selecting bit 7 - i (normal order) or bit i (flipped order) of a bit plane in byte i. */
+constexpr std::uint64_t normal_order_mask  = 0x0102040810204080;
+constexpr std::uint64_t flipped_order_mask = 0x8040201008040201;
+
+constexpr std::uint64_t low_bits  = 0x0101010101010101;
+constexpr std::uint64_t high_bits = 0x7F7F7F7F7F7F7F7F;
+
+/** Moves the bits of a bit plane selected by the mask to bit 0 of separate bytes (see pattern_cache::interleave()). */
+template<std::uint64_t Mask>
+constexpr std::uint64_t spread_bits(std::uint8_t plane) noexcept {
+    std::uint64_t const selected = (plane * low_bits) & Mask;  // Each byte holds a single bit of the plane, or zero
+    return ((selected + high_bits) >> 7) & low_bits;           // Adding 0x7F carries a set bit into bit 7 of its byte
+}
+
+static_assert(spread_bits<normal_order_mask>(0x80) == 0x0000000000000001);
+static_assert(spread_bits<flipped_order_mask>(0x80) == 0x0100000000000000);
+
+} // namespace
+
+/** Interleaves the bit planes of a tile row into one byte per pixel; Mask selects the pixel order. */
+template<std::uint64_t Mask>
+constexpr decoded_tile_row pattern_cache::interleave(tile_row row) noexcept {
+    return decoded_tile_row{spread_bits<Mask>(row.lo) | (spread_bits<Mask>(row.hi) << 1)};
+}
+
+/** Decodes a tile row and stores it for the row that contains the given pattern table address. */
+void pattern_cache::store(vram_address addr, tile_row row, change_stamp stamp) noexcept {
+    std::array<decoded_tile_row, 2> const decoded = {
+        interleave<normal_order_mask>(row),
+        interleave<flipped_order_mask>(row)
+    };
+    if (std::exchange(my_rows[row_index(addr)], decoded) != decoded)
+        my_last_change = stamp;
+}
+
+/** Returns a decoded tile row, horizontally flipped if requested. */
+decoded_tile_row pattern_cache::load(pattern_table_index table_idx, tile_index tile_idx, std::uint8_t row,
+    bool flip_horz) const noexcept
+{
+    assert(row < 8);
+
+    std::size_t const index = (std::to_underlying(table_idx) << 11) | (std::to_underlying(tile_idx) << 3) | row;
+    return my_rows[index][flip_horz];
+}
+
+/** Returns the address of the low bit plane of the tile row that contains the given pattern table address. */
+vram_address pattern_cache::row_address(vram_address addr) noexcept {
+    assert(addr < vram_nametable_addr);
+    return vram_address(addr.to_uint() & ~std::uint16_t{0x0008});
+}
+
+/** Returns the index of the tile row that contains the given pattern table address. */
+std::size_t pattern_cache::row_index(vram_address addr) noexcept {
+    assert(addr < vram_nametable_addr);
+
+    // Pattern table address: 000T'NNNN'NNNN'PRRR (table, tile number, bit plane, row)
+    std::uint16_t const value = addr.to_uint();
+    return ((value & 0x1FF0) >> 1) | (value & 0x0007);
+}
+
+} // namespace emu::ppu